@@ -0,0 +1,233 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+CEMRG ATRIA CLIPPER APP
+Replays the vein clipping of the atrial clipper views from the files they
+record (prodLineSurface.vtk, prodSeedIds.txt, prodSeedLabels.txt and
+prodLineFlip.txt) on one case directory, or on a cohort of them in parallel.
+=========================================================================*/
+
+// Qmitk
+#include <mitkIOUtil.h>
+#include <mitkSurface.h>
+#include <mitkImage.h>
+#include <mitkCommandLineParser.h>
+
+// VTK
+#include <vtkIdList.h>
+
+// Qt
+#include <QtDebug>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include <CemrgAtriaClipper.h>
+#include <CemrgJobScheduler.h>
+#include <CemrgProvenance.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+QStringList ReadLines(QString path){
+  QStringList lines;
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return lines;
+  QTextStream in(&file);
+  while(!in.atEnd()){
+    QString line = in.readLine().trimmed();
+    if(!line.isEmpty())
+      lines << line;
+  }
+  return lines;
+}
+
+int ClipCase(QString direct, QString segName, bool morph, bool verbose){
+  QString sep = QString::fromStdString(mitk::IOUtil::GetDirectorySeparator());
+  QString surfPath = direct + sep + "prodLineSurface.vtk";
+  QString segPath = direct + sep + segName;
+  QStringList labels = ReadLines(direct + sep + "prodSeedLabels.txt");
+  QStringList ids = ReadLines(direct + sep + "prodSeedIds.txt");
+  QStringList flip = ReadLines(direct + sep + "prodLineFlip.txt");
+
+  if(!QFileInfo::exists(surfPath) || !QFileInfo::exists(segPath) || labels.empty() || labels.size() != ids.size()){
+    MITK_ERROR << ("Missing or inconsistent clipper records in: " + direct).toStdString();
+    return EXIT_FAILURE;
+  }
+
+  std::vector<int> pickedSeedLabels;
+  vtkSmartPointer<vtkIdList> pickedSeedIds = vtkSmartPointer<vtkIdList>::New();
+  pickedSeedIds->Initialize();
+  for(int i=0; i<labels.size(); i++){
+    pickedSeedLabels.push_back(labels.at(i).toInt());
+    pickedSeedIds->InsertNextId(ids.at(i).toLongLong());
+  }
+
+  if(verbose) MITK_INFO << ("Loading surface and segmentation of: " + direct).toStdString();
+  mitk::Surface::Pointer surface = mitk::IOUtil::Load<mitk::Surface>(surfPath.toStdString());
+  mitk::Image::Pointer segImage = mitk::IOUtil::Load<mitk::Image>(segPath.toStdString());
+
+  std::unique_ptr<CemrgAtriaClipper> clipper(new CemrgAtriaClipper(direct, surface));
+  if(verbose) MITK_INFO << "[...] Centre lines";
+  clipper->ComputeCtrLines(pickedSeedLabels, pickedSeedIds, !flip.empty() && flip.at(0).toInt() != 0);
+  if(verbose) MITK_INFO << "[...] Clipper planes";
+  clipper->ComputeCtrLinesClippers(pickedSeedLabels);
+  if(verbose) MITK_INFO << "[...] Clipping segmentation";
+  clipper->ClipVeinsImage(pickedSeedLabels, segImage, morph);
+  CemrgProvenance::Flush();
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]){
+  mitkCommandLineParser parser;
+
+  // Set general information about your command-line app
+  parser.setCategory("Scar processing");
+  parser.setTitle("Atria Clipper Command-line App");
+  parser.setContributor("CEMRG, KCL");
+  parser.setDescription(
+    "Clip the pulmonary veins of atrial segmentations from recorded seeds.");
+
+  // How should arguments be prefixed
+  parser.setArgumentPrefix("--", "-");
+
+  // Add arguments. Unless specified otherwise, each argument is optional.
+  parser.addArgument(
+    "input-path", "p", mitkCommandLineParser::InputDirectory,
+    "Case directory", "Directory with the prod* files of a clipper session.");
+  parser.addArgument(
+    "cohort", "c", mitkCommandLineParser::InputFile,
+    "Cohort list", "Text file with one case directory per line.");
+  parser.addArgument(
+    "segmentation", "s", mitkCommandLineParser::String,
+    "Segmentation file name", "Name of the segmentation inside each case directory.",
+    us::Any(), false);
+  parser.addArgument(
+    "jobs", "j", mitkCommandLineParser::Int,
+    "Parallel cases", "Number of cases clipped at once (default: CPU budget).");
+  parser.addArgument( // optional
+    "morphology", "m", mitkCommandLineParser::Bool,
+    "Morphological analysis", "Whether to write morphResults.txt");
+  parser.addArgument( // optional
+    "verbose", "v", mitkCommandLineParser::Bool,
+    "Verbose Output", "Whether to produce verbose output");
+
+  // Parse arguments.
+  // This method returns a mapping of long argument names to their values.
+  auto parsedArgs = parser.parseArguments(argc, argv);
+
+  if (parsedArgs.empty())
+    return EXIT_FAILURE;
+
+  if (parsedArgs["segmentation"].Empty() ||
+      (parsedArgs["input-path"].Empty() && parsedArgs["cohort"].Empty())){
+    MITK_INFO << parser.helpText();
+    return EXIT_FAILURE;
+  }
+
+  // Parse, cast and set required arguments
+  QString segName = QString::fromStdString(us::any_cast<std::string>(parsedArgs["segmentation"]));
+
+  // Default values for optional arguments
+  auto verbose = false;
+  auto morph = false;
+  int jobs = CemrgJobScheduler::GetInstance()->GetCpuBudget();
+
+  // Parse, cast and set optional arguments
+  if (parsedArgs.end() != parsedArgs.find("verbose")){
+    verbose = us::any_cast<bool>(parsedArgs["verbose"]);
+  }
+  if (parsedArgs.end() != parsedArgs.find("morphology")){
+    morph = us::any_cast<bool>(parsedArgs["morphology"]);
+  }
+  if (parsedArgs.end() != parsedArgs.find("jobs")){
+    jobs = std::max(1, us::any_cast<int>(parsedArgs["jobs"]));
+  }
+
+  try{
+    // Replays must not overwrite the records they read
+    CemrgProvenance::SetEnabled(false);
+
+    if(parsedArgs["cohort"].Empty()){
+      QString direct = QFileInfo(QString::fromStdString(us::any_cast<std::string>(parsedArgs["input-path"]))).absoluteFilePath();
+      return ClipCase(direct, segName, morph, verbose);
+    }
+
+    // Cohort mode, one child process per case sharing the CPU budget
+    QStringList cases = ReadLines(QString::fromStdString(us::any_cast<std::string>(parsedArgs["cohort"])));
+    jobs = std::min(jobs, std::max(1, cases.size()));
+    int budget = CemrgJobScheduler::GetInstance()->GetCpuBudget();
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("CEMRG_CPU_BUDGET", QString::number(std::max(1, budget / jobs)));
+    MITK_INFO << ("Clipping " + QString::number(cases.size()) + " cases, " + QString::number(jobs) + " at a time.").toStdString();
+
+    int next = 0, failures = 0;
+    std::vector<std::pair<QString, QProcess*>> running;
+    while(next < cases.size() || !running.empty()){
+
+      while(next < cases.size() && (int)running.size() < jobs){
+        QStringList arguments;
+        arguments << "-p" << cases.at(next) << "-s" << segName;
+        if(morph) arguments << "-m";
+        if(verbose) arguments << "-v";
+        QProcess* process = new QProcess();
+        process->setProcessEnvironment(env);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->start(QString::fromLocal8Bit(argv[0]), arguments);
+        // A child that never started reports a normal exit with code 0
+        if(process->waitForStarted()){
+          running.push_back(std::make_pair(cases.at(next), process));
+        } else {
+          MITK_WARN << ("Failed to start: " + cases.at(next) + " (" + process->errorString() + ")").toStdString();
+          failures++;
+          delete process;
+        }
+        next++;
+      }
+
+      for(size_t i=0; i<running.size(); i++){
+        QProcess* process = running[i].second;
+        if(process->state() != QProcess::NotRunning && !process->waitForFinished(100))
+          continue;
+        bool ok = process->exitStatus() == QProcess::NormalExit && process->exitCode() == 0;
+        MITK_INFO << ((ok ? "Finished: " : "Failed: ") + running[i].first).toStdString();
+        if(!ok) failures++;
+        delete process;
+        running.erase(running.begin() + i);
+        break;
+      }
+    }
+
+    MITK_INFO << ("Cohort done, " + QString::number(failures) + " failures.").toStdString();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  catch (const std::exception &e){
+    MITK_ERROR << e.what();
+    return EXIT_FAILURE;
+  }
+  catch(...){
+    MITK_ERROR << "Unexpected error";
+    return EXIT_FAILURE;
+  }
+}
@@ -6,6 +6,16 @@ set(CPP_FILES
     CemrgStrains.cpp
     CemrgAtriaClipper.cpp
     CemrgTests.cpp
+    CemrgJobScheduler.cpp
+    CemrgTrace.cpp
+    CemrgRegistration.cpp
+    CemrgFFDTransform.cpp
+    CemrgProvenance.cpp
+    CemrgVtkPointReader.cpp
+    CemrgIntensityStats.cpp
+    CemrgRunLengthImage.cpp
+    CemrgConnectedComponents.cpp
+    CemrgWallThickness.cpp
 )
 
 set(UI_FILES
@@ -15,6 +25,16 @@ set(MOC_H_FILES
   include/CemrgAtriaClipper.h
   include/CemrgCommandLine.h
   include/CemrgImageUtils.h
+  include/CemrgJobScheduler.h
+  include/CemrgTrace.h
+  include/CemrgRegistration.h
+  include/CemrgFFDTransform.h
+  include/CemrgProvenance.h
+  include/CemrgVtkPointReader.h
+  include/CemrgIntensityStats.h
+  include/CemrgRunLengthImage.h
+  include/CemrgConnectedComponents.h
+  include/CemrgWallThickness.h
   include/CemrgMeasure.h
   include/CemrgScar3D.h
   include/CemrgStrains.h
@@ -36,7 +36,9 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vtkRegularPolygonSource.h>
 #include <vtkvmtkPolyDataCenterlines.h>
 #include <vtkvmtkPolyDataCenterlineSections.h>
+#include <itkImage.h>
 #include <QString>
+#include "CemrgRunLengthImage.h"
 
 // The following header file is generated by CMake and thus it's located in
 // the build directory. It provides an export macro for classes and functions
@@ -55,6 +57,8 @@ public:
     void ComputeCtrLinesClippers(std::vector<int> pickedSeedLabels);
     void ClipVeinsMesh(std::vector<int> pickedSeedLabels);
     void ClipVeinsImage(std::vector<int> pickedSeedLabels, mitk::Image::Pointer segImage, bool morphAnalysis);
+    void ComputeMorphology(std::vector<int> pickedSeedLabels);
+    void ComputeMorphology(std::vector<int> pickedSeedLabels, std::vector<vtkSmartPointer<vtkPolyData>> veinSections);
     void CalcParamsOfPlane(vtkSmartPointer<vtkRegularPolygonSource> plane, int ctrLineNo, int position);
     void ResetCtrLinesClippingPlanes();
 
@@ -62,12 +66,14 @@ public:
     mitk::Surface::Pointer GetClippedSurface() const;
     std::vector<vtkSmartPointer<vtkvmtkPolyDataCenterlines>> GetCentreLines() const;
     std::vector<vtkSmartPointer<vtkRegularPolygonSource>> GetCentreLinePolyPlanes() const;
+    vtkSmartPointer<vtkPolyData> GetCentreLineVeinPlanes(int ctrLineNo);
     std::vector<std::vector<double>> GetMClipperAngles();
     std::vector<int> GetManualType() const;
     void SetToAutomaticClipperMode(int clippersIndex);
     void SetMClipperAngles(double* value, int clippersIndex);
     void SetMClipperSeeds(vtkSmartPointer<vtkPolyData> pickedCutterSeeds, int clippersIndex);
     void SetRadiusAdjustment(double value);
+    void SetCutterModified(int clippersIndex);
 
 protected:
 
@@ -75,13 +81,18 @@ protected:
 private:
 
     vtkIdType CentreOfMass(mitk::Surface::Pointer surface);
+    vtkSmartPointer<vtkPolyData> CentreLineSection(vtkPolyData* surfacePD, vtkPolyData* line, int position);
+    std::vector<vtkSmartPointer<vtkPolyData>> CutterSections(std::vector<bool> needed);
+    int OstiumPosition(vtkPolyData* surfacePD, vtkPolyData* line);
+    itk::Image<short,3>::Pointer CutterMask(
+            vtkSmartPointer<vtkPolyData> circle, double* normal, itk::Image<short,3>::Pointer segItkImage, unsigned long radius);
     void VTKWriter(vtkSmartPointer<vtkPolyData> PD, QString path);
 
     QString directory;
     mitk::Surface::Pointer surface;
     mitk::Surface::Pointer clippedSurface;
     mitk::Image::Pointer clippedSegImage;
-    std::vector<vtkSmartPointer<vtkPolyData>> centreLineVeinPlanes;
+    std::vector<vtkSmartPointer<vtkPolyData>> centreLineVeinPlanes; //All sections, built on request
     std::vector<vtkSmartPointer<vtkRegularPolygonSource>> centreLinePolyPlanes;
     std::vector<vtkSmartPointer<vtkPoints>> centreLinePointPlanes;
     std::vector<vtkSmartPointer<vtkvmtkPolyDataCenterlines>> centreLines;
@@ -96,6 +107,16 @@ private:
     //Cutters properties
     std::vector<int> manuals; //Cutter's tilt manual or automatic
     std::vector<std::vector<double>> normalPlAngles; //Cutter's tilt adjustments
+    std::vector<itk::Image<short,3>::Pointer> cutterMasks; //Cut masks of the last image clip
+    std::vector<bool> cutterDirty; //Cutters changed since their mask was built
+    std::vector<std::vector<itk::OffsetValueType>> cutterVoxels; //Voxels each cutter removed in the last image clip
+    std::vector<int> cutterLabels; //Vein labels of the last image clip
+    mitk::Image::Pointer cutterMasksImage; //Segmentation the masks were built on
+    unsigned long cutterMasksTime;
+    itk::Image<short,3>::Pointer cutOrgItkImage; //Segmentation of the last image clip
+    itk::Image<short,3>::Pointer cutSegItkImage; //Merged cuts before keeping the largest component
+    itk::Image<short,3>::Pointer cutLblItkImage; //Merged cuts before labelling the veins
+    CemrgRunLengthImage cutOrgRuns;
 
     //Constant Vein Labels
     //const int LEFTSUPERIORPV  = 11;
@@ -85,10 +85,15 @@ public:
 
     // Helper functions
     bool isOutputSuccessful(QString outputfullpath);
+    bool ExecuteConcurrently(QString program, QList<QStringList> argumentsList, QString workingDirectory);
     void ExecuteTouch(QString filepath);
     std::string printFullCommand(QString command, QStringList arguments);
     void checkForStartedProcess();
 
+    //Mesh format of the external tools, binary unless CEMRG_VTK_ASCII is set
+    static bool GetVtkAsciiOutput() { return vtkAsciiOutput; }
+    static void SetVtkAsciiOutput(bool value) { vtkAsciiOutput = value; }
+
 protected slots:
 
     void UpdateStdText();
@@ -107,6 +112,7 @@ private:
     std::unique_ptr<QProcess> process;
     bool completion;
     bool isUI;
+    static bool vtkAsciiOutput;
 };
 
 #endif // CemrgCommandLine_h
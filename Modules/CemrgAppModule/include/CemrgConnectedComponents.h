@@ -0,0 +1,79 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Connected Components for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgConnectedComponents_h
+#define CemrgConnectedComponents_h
+
+#include <vector>
+#include <itkImage.h>
+#include <MitkCemrgAppModuleExports.h>
+#include "CemrgRunLengthImage.h"
+
+
+/**
+ * Face-connected components of the non-zero voxels, as the ITK
+ * ConnectedComponentImageFilter followed by RelabelComponentImageFilter.
+ * Labelling works on the foreground runs of a CemrgRunLengthImage with a
+ * union-find over runs, slabs of slices in parallel and their borders
+ * merged afterwards. Components come out ordered by decreasing size with
+ * their voxel counts and index bounding boxes, so keeping the largest
+ * ones needs no further filter.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgConnectedComponents {
+
+public:
+
+    typedef itk::Image<short,3> ImageType;
+
+    struct Component {
+        long long voxels;
+        ImageType::RegionType box;
+    };
+
+    CemrgConnectedComponents();
+    CemrgConnectedComponents(ImageType::Pointer image);
+    CemrgConnectedComponents(const CemrgRunLengthImage& mask);
+    void Compute(ImageType::Pointer image);
+    void Compute(const CemrgRunLengthImage& mask);
+
+    //Label i+1 is component i, largest first
+    int GetNumberOfComponents() const;
+    const std::vector<Component>& GetComponents() const;
+
+    //All components, the N largest only, or a chosen set of labels
+    ImageType::Pointer GetLabelledImage(int noLargest = 0) const;
+    ImageType::Pointer GetLabelledImage(const std::vector<int>& keepLabels) const;
+
+private:
+
+    CemrgRunLengthImage runImage;
+    std::vector<int> runComponents;
+    std::vector<Component> components;
+};
+
+#endif // CemrgConnectedComponents_h
@@ -0,0 +1,76 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * FFD Transformation for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgFFDTransform_h
+#define CemrgFFDTransform_h
+
+#include <vector>
+#include <vtkSmartPointer.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <QString>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Native evaluator of the spatio-temporal cubic B-spline free-form
+ * deformation written by MIRTK motion tracking (tsffd.dof), as applied by
+ * transform-points -St. Points are in MIRTK world coordinates, i.e. with x
+ * and y flipped with respect to MITK. Read rejects velocity based models,
+ * which MIRTK integrates over time, and any file whose type or layout it
+ * does not recognise, in which case callers keep using MIRTK.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgFFDTransform {
+
+public:
+
+    CemrgFFDTransform();
+
+    bool Read(QString dofPath);
+    bool IsValid() const;
+    unsigned int GetType() const;
+
+    //Deforms all points for every time point in one batched call
+    std::vector<vtkSmartPointer<vtkPoints>> TransformPoints(vtkPoints* points, const std::vector<double>& times) const;
+    bool WriteTransformedMeshes(QString dir, vtkPolyData* input, const std::vector<double>& times, bool ascii) const;
+
+private:
+
+    void Displacements(const double* point, const std::vector<double>& times, double* output) const;
+    bool ParseLayout(const std::vector<char>& buffer, bool bigEndian);
+
+    bool valid;
+    unsigned int type;
+    int nx, ny, nz, nt;
+    double axes[3][3];
+    double spacing[4];
+    double origin[4];
+    std::vector<double> coefficients;
+};
+
+#endif // CemrgFFDTransform_h
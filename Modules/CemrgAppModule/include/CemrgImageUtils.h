@@ -30,6 +30,12 @@ PURPOSE.  See the above copyright notices for more information.
 #define CemrgImageUtils_h
 
 // #include <MyCemrgLibExports.h>
+#include <vector>
+#include <QString>
+#include <mitkImage.h>
+#include <mitkDataNode.h>
+#include <mitkBoundingObject.h>
+#include <itkImageRegion.h>
 #include <MitkCemrgAppModuleExports.h>
 
 
@@ -37,6 +43,12 @@ class MITKCEMRGAPPMODULE_EXPORT CemrgImageUtils {
 
 public:
 
+    //Cropping with a fixed box, thread-safe once constructed
+    CemrgImageUtils(mitk::BoundingObject::Pointer cuttingCube, mitk::Image::Pointer referenceImage);
+    bool IsValid() const;
+    mitk::Image::Pointer Crop(mitk::Image::Pointer image) const;
+    int CropSeries(QString dir, int noFrames, int firstFrame = 0, QString prefix = "dcm-") const;
+
     //Cropping Utils
     static mitk::Image::Pointer CropImage();
     static void SetImageToCut(mitk::Image::Pointer imageToCut);
@@ -45,13 +57,26 @@ public:
     static void SetCuttingNode(mitk::DataNode::Pointer cuttingNode);
     static mitk::DataNode::Pointer GetImageNode();
     static mitk::DataNode::Pointer GetCuttingNode();
+    static mitk::Image::Pointer GetImageToCut();
+    static mitk::BoundingObject::Pointer GetCuttingCube();
 
     //Sampling Utils
-    static mitk::Image::Pointer Downsample(mitk::Image::Pointer image, int factor);
+    static mitk::Image::Pointer Downsample(mitk::Image::Pointer image, int factor, bool average = false);
+    static int DownsampleSeries(QString dir, int noFrames, int factor, int firstFrame = 0, QString prefix = "dcm-", bool average = false);
 
 private:
 
+    //Index region of the box and inside flags of its voxels, x fastest
+    itk::ImageRegion<3> cropRegion;
+    std::vector<bool> insideVoxels;
+    bool fullyInside;
+    bool valid;
+
     //Cropping Utils
+    static mitk::Image::Pointer CropWithCutter();
+
+    //Sampling Utils
+    static mitk::Image::Pointer Decimate(mitk::Image::Pointer image, int factor, bool average);
     static mitk::Image::Pointer imageToCut;
     static mitk::BoundingObject::Pointer cuttingCube;
     static mitk::DataNode::Pointer imageNode;
@@ -0,0 +1,75 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Intensity Statistics for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgIntensityStats_h
+#define CemrgIntensityStats_h
+
+#include <vector>
+#include <itkImage.h>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Statistics of the image intensities under a mask (voxels where the mask
+ * is not zero), gathered in one parallel pass into an exact histogram of
+ * the short range. Mean, standard deviation, extremes, percentiles and the
+ * mean of the brightest fraction are then read off the histogram without
+ * copying or sorting the voxels.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgIntensityStats {
+
+public:
+
+    typedef itk::Image<short,3> ImageType;
+
+    CemrgIntensityStats();
+    CemrgIntensityStats(ImageType::Pointer image, ImageType::Pointer mask, bool skipZeros = false);
+    //Zero intensities under the mask are left out when skipZeros is set
+    void Compute(ImageType::Pointer image, ImageType::Pointer mask, bool skipZeros = false);
+
+    long long GetCount() const;
+    double GetMean() const;
+    double GetStdDev() const;
+    double GetMin() const;
+    double GetMax() const;
+
+    //Value at a fraction of the sorted intensities, 0.5 is the median
+    double GetPercentile(double fraction) const;
+    //Mean of the brightest fraction of the intensities
+    double GetTopMean(double fraction) const;
+
+private:
+
+    long long count;
+    double mean;
+    double stdDev;
+    int minValue, maxValue;
+    std::vector<long long> histogram;
+};
+
+#endif // CemrgIntensityStats_h
@@ -0,0 +1,110 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Job Scheduler for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgJobScheduler_h
+#define CemrgJobScheduler_h
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Process-wide owner of the CPU budget. External tools and in-process
+ * workers reserve threads from it, so concurrent views and pipeline steps
+ * share the machine instead of each assuming they own every core.
+ * The budget defaults to the hardware concurrency and can be overridden
+ * with the CEMRG_CPU_BUDGET environment variable.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgJobScheduler {
+
+public:
+
+    static CemrgJobScheduler* GetInstance();
+
+    //Budget
+    int GetCpuBudget() const;
+    void SetCpuBudget(int cores);
+    int GetIdleThreads() const;
+    int ThreadsPerJob(int noJobs) const;
+
+    //Reservations, blocks until at least minimum threads are idle
+    int AcquireThreads(int requested, int minimum = 1);
+    int TryAcquireThreads(int requested);
+    void ReleaseThreads(int threads);
+
+    //Queued jobs, started in order as soon as their threads are idle
+    std::shared_future<void> Submit(std::function<void(int)> job, int requested = 1);
+    void WaitForAll();
+
+    //Splits [0, count) into chunks run on as many threads as are idle
+    static void ParallelFor(int count, std::function<void(int, int)> body, int grain = 1);
+
+    /**
+     * Scoped reservation of threads, released on destruction
+     */
+    class MITKCEMRGAPPMODULE_EXPORT Reservation {
+
+    public:
+
+        Reservation(int requested, int minimum = 1);
+        ~Reservation();
+        int GetThreads() const;
+
+    private:
+
+        int threads;
+        Reservation(const Reservation&);
+        Reservation& operator=(const Reservation&);
+    };
+
+private:
+
+    CemrgJobScheduler();
+    void Dispatch();
+
+    struct Job {
+        std::function<void(int)> task;
+        int requested;
+        std::shared_ptr<std::promise<void>> done;
+    };
+
+    int cpuBudget;
+    int busyThreads;
+    int runningJobs;
+    std::deque<Job> pendingJobs;
+    mutable std::mutex mutex;
+    std::condition_variable released;
+};
+
+#endif // CemrgJobScheduler_h
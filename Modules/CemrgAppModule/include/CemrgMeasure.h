@@ -31,13 +31,38 @@ PURPOSE.  See the above copyright notices for more information.
 
 // #include <MyCemrgLibExports.h>
 #include <MitkCemrgAppModuleExports.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
 #include <QDebug>
+#include <vector>
+#include "CemrgVtkPointReader.h"
 
 
 class MITKCEMRGAPPMODULE_EXPORT CemrgMeasure {
 
 public:
 
+    //Shape metrics of a closed surface mesh
+    struct ShapeMetrics {
+        double area;
+        double volume;
+        double centroid[3]; //Area weighted
+        double meanRadius;
+        double sigma;
+        double sphericity;
+        bool valid; //False for unreadable meshes or meshes without polygons
+    };
+
+    //Shape metrics over a cardiac cycle
+    struct SeriesMetrics {
+        std::vector<ShapeMetrics> frames;
+        std::vector<double> volumes; //NaN for invalid frames
+        std::vector<int> invalidFrames; //Left out of the summary
+        double edv, esv, strokeVolume, ef; //Largest and smallest volumes, EF in %
+        int edFrame, esFrame;
+        int maxSphericityFrame, minSphericityFrame;
+    };
+
     //Point to Point Tools
     void Convert(QString dir, mitk::DataNode::Pointer);
     std::vector <std::tuple<double, double, double>> Deconvert(QString dir, int noFile);
@@ -47,7 +72,10 @@ public:
     mitk::Point3D FindCentre(mitk::PointSet::Pointer pointset);
 
     //Sphericity Tools
+    ShapeMetrics GetShapeMetrics(vtkPolyData* poly);
     double GetSphericity(vtkPolyData* poly);
+    SeriesMetrics GetSeriesMetrics(std::vector<vtkSmartPointer<vtkPolyData>> meshes);
+    SeriesMetrics GetSeriesMetrics(QString dir, int noFrames, QString prefix = "transformed-");
 
     //Mesh Mass Tools
     double calcVolumeMesh(mitk::Surface::Pointer surface);
@@ -62,11 +90,10 @@ private:
     std::vector<std::string>& Split(const std::string& str, std::vector<std::string>& elements);
 
     //Sphericity Tools
-    void GetArea(vtkPolyData* polys, double* TiA, double& LACA);
-    void GetCentreOfMass(double** TiMC, double* TiA, int TiMC_size, double LACA, double* LAC_mc);
-    void GetCentreOfMassOfEachT(vtkPolyData* polys, double** TiMC);
-    void GetAverageRadius(double** TiMC, double* TiA, double TiMC_size, double* LAC_mc, double LACA, double& AR);
-    void LASphericity(double** TiMC, double* TiA, double TiMC_size, double* LAC_mc, double LACA, double AR, double& sigma, double& Sphericity);
+    SeriesMetrics SummariseSeries(std::vector<ShapeMetrics>& frames);
+
+    //Reused across frames so the coordinate buffer is allocated once
+    CemrgVtkPointReader pointReader;
 };
 
 #endif // CemrgMeasure_h
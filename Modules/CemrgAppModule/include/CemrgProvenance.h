@@ -0,0 +1,66 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Provenance Journal for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgProvenance_h
+#define CemrgProvenance_h
+
+#include <atomic>
+#include <string>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <QString>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Background writer for the reproducibility (prod*) files of the pipelines.
+ * Artifacts are copied when queued and written in order on a single worker
+ * thread, so the calling computation does not wait for disk or for mesh
+ * serialisation. The journal is on by default; CEMRG_PROVENANCE=0 in the
+ * environment or SetEnabled(false) turns it off for batch runs.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgProvenance {
+
+public:
+
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool value);
+
+    //Queue artifacts, the mesh is deep copied before returning
+    static void WritePolyData(vtkSmartPointer<vtkPolyData> polyData, QString path);
+    static void WriteText(QString path, std::string content);
+
+    //Blocks until every queued artifact is on disk
+    static void Flush();
+
+private:
+
+    static std::atomic<bool> enabled;
+};
+
+#endif // CemrgProvenance_h
@@ -0,0 +1,75 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Rigid Registration for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgRegistration_h
+#define CemrgRegistration_h
+
+#include <mitkImage.h>
+#include <itkVersorRigid3DTransform.h>
+#include <QString>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * In-process multi-resolution rigid registration (Mattes mutual information,
+ * versor rigid transform) following the conventions of MIRTK register:
+ * the fixed image is the target and the moving image the source, so the
+ * transform maps target points onto source points.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgRegistration {
+
+public:
+
+    typedef itk::VersorRigid3DTransform<double> RigidTransformType;
+
+    CemrgRegistration();
+
+    bool RigidRegistration(mitk::Image::Pointer fixed, mitk::Image::Pointer moving);
+    mitk::Image::Pointer TransformImage(mitk::Image::Pointer image, bool labelImage);
+
+    //Transformation IO
+    bool SaveTransform(QString path);
+    bool LoadTransform(QString path);
+    bool SaveMIRTKDof(QString path);
+
+    mitk::Image::Pointer GetResampledImage() const;
+    RigidTransformType::Pointer GetTransform() const;
+    void SetNumberOfIterations(int value);
+    void SetNumberOfHistogramBins(int value);
+    void SetSamplingPercentage(double value);
+
+private:
+
+    int iterations;
+    int histogramBins;
+    double samplingPercentage;
+    RigidTransformType::Pointer transform;
+    mitk::Image::Pointer resampledImage;
+};
+
+#endif // CemrgRegistration_h
@@ -0,0 +1,94 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Run-Length Label Images for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgRunLengthImage_h
+#define CemrgRunLengthImage_h
+
+#include <map>
+#include <vector>
+#include <itkImage.h>
+#include <mitkImage.h>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Label volume stored as runs of equal non-zero labels along x. Background
+ * is not stored, so binary masks and label maps covering a small part of
+ * the volume take a fraction of the dense memory, and loops over the
+ * foreground skip empty space. Voxel counts and index bounding boxes of
+ * every label are gathered while encoding.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgRunLengthImage {
+
+public:
+
+    typedef itk::Image<short,3> ImageType;
+
+    struct Run {
+        int x, y, z;
+        unsigned int length;
+        short label;
+    };
+
+    CemrgRunLengthImage();
+    CemrgRunLengthImage(ImageType::Pointer image);
+    CemrgRunLengthImage(mitk::Image::Pointer image);
+
+    //Conversions
+    void SetImage(ImageType::Pointer image);
+    void SetImage(mitk::Image::Pointer image);
+    ImageType::Pointer GetItkImage() const;
+    mitk::Image::Pointer GetMitkImage() const;
+    //Runs painted with new labels, one per run, zero drops a run
+    ImageType::Pointer GetItkImage(const std::vector<short>& runLabels) const;
+
+    //Foreground runs ordered by slice, row and column
+    const std::vector<Run>& GetRuns() const;
+    ImageType::RegionType GetRegion() const;
+    ImageType::OffsetValueType GetOffset(const Run& run) const;
+
+    //Label statistics
+    std::vector<short> GetLabels() const;
+    long long GetVoxelCount(short label) const;
+    long long GetForegroundCount() const;
+    bool GetBoundingBox(short label, ImageType::RegionType& box) const;
+    size_t GetMemorySize() const;
+
+private:
+
+    struct LabelInfo {
+        long long voxels;
+        ImageType::IndexType min, max;
+    };
+
+    ImageType::Pointer header;
+    std::vector<Run> runs;
+    std::map<short, LabelInfo> labels;
+};
+
+#endif // CemrgRunLengthImage_h
@@ -0,0 +1,93 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Timing Trace for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgTrace_h
+#define CemrgTrace_h
+
+#include <atomic>
+#include <QString>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Scoped timing spans written as Chrome trace-event JSON (chrome://tracing,
+ * Perfetto) to cemrgTrace.json inside the project directory of each span.
+ * Every span records wall time, the peak resident memory of the process so
+ * far and how much the span raised it, and the largest peak of the finished
+ * child processes (external tools). Events are appended to the file when
+ * the outermost span of a thread closes.
+ * Tracing is off unless CEMRG_TRACE is set in the environment or SetEnabled
+ * is called. The directory argument of CEMRG_TRACE_SCOPE is only evaluated
+ * while tracing is on, a disabled span costs a relaxed atomic load and an
+ * empty QString.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgTrace {
+
+public:
+
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool value);
+    static void Flush(QString directory);
+
+    class MITKCEMRGAPPMODULE_EXPORT Scope {
+
+    public:
+
+        Scope(const char* name, const QString& directory) : active(CemrgTrace::IsEnabled()) {
+            if (active) Begin(name, directory);
+        }
+        ~Scope() {
+            if (active) End();
+        }
+
+    private:
+
+        void Begin(const char* name, const QString& directory);
+        void End();
+
+        bool active;
+        const char* name;
+        QString directory;
+        long long start;
+        long long startPeakRssKb;
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+
+private:
+
+    static std::atomic<bool> enabled;
+};
+
+#define CEMRG_TRACE_CONCAT_(a, b) a##b
+#define CEMRG_TRACE_CONCAT(a, b) CEMRG_TRACE_CONCAT_(a, b)
+#define CEMRG_TRACE_SCOPE(name, directory) \
+    CemrgTrace::Scope CEMRG_TRACE_CONCAT(cemrgTraceScope, __LINE__)(name, \
+        CemrgTrace::IsEnabled() ? QString(directory) : QString())
+
+#endif // CemrgTrace_h
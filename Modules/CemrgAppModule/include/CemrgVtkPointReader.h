@@ -0,0 +1,67 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Fast VTK Point Reader for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgVtkPointReader_h
+#define CemrgVtkPointReader_h
+
+#include <vector>
+#include <QString>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Reads only the POINTS section of a legacy VTK polydata file, ASCII or
+ * binary, from a memory map of the file. ASCII numbers are parsed in place
+ * without temporary strings or locale lookups, straight into a coordinate
+ * buffer that is kept between reads of the same instance. X and Y can be
+ * negated in the same pass to move between MIRTK and MITK coordinates.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgVtkPointReader {
+
+public:
+
+    CemrgVtkPointReader();
+
+    bool Read(QString path);
+    void SetFlipXY(bool value);
+
+    //Interleaved x, y, z of the last successful read
+    const std::vector<double>& GetCoordinates() const;
+    size_t GetNumberOfPoints() const;
+
+    static bool ParseDouble(const char*& cursor, const char* end, double& value);
+
+private:
+
+    bool ParsePoints(const char* data, const char* end);
+
+    bool flipXY;
+    std::vector<double> coordinates;
+};
+
+#endif // CemrgVtkPointReader_h
@@ -0,0 +1,95 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Wall Thickness for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+#ifndef CemrgWallThickness_h
+#define CemrgWallThickness_h
+
+#include <vector>
+#include <string>
+#include <itkImage.h>
+#include <vtkPolyData.h>
+#include <MitkCemrgAppModuleExports.h>
+
+
+/**
+ * Laplace wall thickness computed in process. The potential is solved on
+ * the wall voxels, fixed to 0 on the blood pool and 1 everywhere else,
+ * with red-black SOR sweeps that update each colour in parallel. Every
+ * wall voxel then follows the potential gradient both ways until it
+ * leaves the wall, and the length of that streamline is its thickness.
+ * Lengths are in the physical units of the image spacing.
+ */
+class MITKCEMRGAPPMODULE_EXPORT CemrgWallThickness {
+
+public:
+
+    typedef itk::Image<short,3> LabelImageType;
+    typedef itk::Image<float,3> FloatImageType;
+
+    //Outcome of the last Compute
+    enum Status {
+        SUCCESS,
+        NO_INPUT,
+        NO_WALL,
+        NO_BLOOD_POOL,
+        NO_CONTACT
+    };
+
+    CemrgWallThickness();
+
+    //Solver settings
+    void SetLabels(short wallLabel, short bloodPoolLabel);
+    void SetTolerance(double tolerance);
+    void SetMaximumIterations(int iterations);
+
+    //False when a label is missing or the wall never touches the blood pool
+    bool Compute(LabelImageType::Pointer segmentation);
+    Status GetStatus() const;
+    int GetIterations() const;
+    double GetResidual() const;
+
+    //Zero outside the wall
+    FloatImageType::Pointer GetThickness() const;
+
+    //Adds a point array with the thickness of the nearest wall voxel within
+    //radius mm, points in world coordinates. Returns the number of points matched
+    int SampleOnSurface(vtkPolyData* surface, std::string arrayName = "Thickness", double radius = 2) const;
+
+private:
+
+    short wallLabel;
+    short bloodPoolLabel;
+    double tolerance;
+    int maxIterations;
+    Status status;
+    int iterations;
+    double residual;
+    FloatImageType::Pointer thickness;
+};
+
+#endif // CemrgWallThickness_h
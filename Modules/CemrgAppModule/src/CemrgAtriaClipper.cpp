@@ -50,15 +50,14 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vtkPolyDataWriter.h>
 #include <vtkPolygon.h>
 #include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkvmtkPolyDataBranchSections.h>
 
 //ITK
-#include <itkSubtractImageFilter.h>
-#include <itkConnectedComponentImageFilter.h>
-#include <itkLabelShapeKeepNObjectsImageFilter.h>
 #include <itkImageRegionIteratorWithIndex.h>
 #include <itkBinaryBallStructuringElement.h>
 #include <itkGrayscaleDilateImageFilter.h>
-#include <itkRelabelComponentImageFilter.h>
 #include <itkImageDuplicator.h>
 #include <itkResampleImageFilter.h>
 #include <itkNearestNeighborInterpolateImageFunction.h>
@@ -67,8 +66,17 @@ PURPOSE.  See the above copyright notices for more information.
 #include <QDebug>
 #include <QString>
 
+//Std
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+
 //CemrgAppModule
-#include "CemrgMeasure.h"
+#include "CemrgTrace.h"
+#include "CemrgJobScheduler.h"
+#include "CemrgProvenance.h"
+#include "CemrgRunLengthImage.h"
+#include "CemrgConnectedComponents.h"
 
 
 CemrgAtriaClipper::CemrgAtriaClipper(QString directory, mitk::Surface::Pointer surface) {
@@ -77,31 +85,31 @@ CemrgAtriaClipper::CemrgAtriaClipper(QString directory, mitk::Surface::Pointer s
     this->surface = surface;
     this->clippedSurface = surface;
     this->clippedSegImage = mitk::Image::New();
+    this->cutterMasksTime = 0;
 }
 
 void CemrgAtriaClipper::ComputeCtrLines(std::vector<int> pickedSeedLabels, vtkSmartPointer<vtkIdList> pickedSeedIds, bool flip) {
 
+    CEMRG_TRACE_SCOPE("CemrgAtriaClipper::ComputeCtrLines", directory);
+
     /*
      * Producibility Test
      **/
-    try {
+    if (CemrgProvenance::IsEnabled()) {
         QString prodPath = directory + mitk::IOUtil::GetDirectorySeparator();
-        mitk::IOUtil::Save(surface, (prodPath + "prodLineSurface.vtk").toStdString());
-        ofstream prodFile1;
-        prodFile1.open((prodPath + "prodSeedLabels.txt").toStdString());
+        CemrgProvenance::WritePolyData(surface->GetVtkPolyData(), prodPath + "prodLineSurface.vtk");
+        std::ostringstream prodFile1;
         for (unsigned int i=0; i<pickedSeedLabels.size(); i++)
             prodFile1 << pickedSeedLabels.at(i) << "\n";
-        prodFile1.close();
-        ofstream prodFile2;
-        prodFile2.open((prodPath + "prodSeedIds.txt").toStdString());
+        CemrgProvenance::WriteText(prodPath + "prodSeedLabels.txt", prodFile1.str());
+        std::ostringstream prodFile2;
         for (unsigned int i=0; i<pickedSeedIds->GetNumberOfIds(); i++)
             prodFile2 << pickedSeedIds->GetId(i) << "\n";
-        prodFile2.close();
-        ofstream prodFile3;
-        prodFile3.open((prodPath + "prodLineFlip.txt").toStdString());
+        CemrgProvenance::WriteText(prodPath + "prodSeedIds.txt", prodFile2.str());
+        std::ostringstream prodFile3;
         prodFile3 << flip << "\n";
-        prodFile3.close();
-    } catch(...) {};
+        CemrgProvenance::WriteText(prodPath + "prodLineFlip.txt", prodFile3.str());
+    }//_if
     /*
      * End Test
      **/
@@ -110,20 +118,28 @@ void CemrgAtriaClipper::ComputeCtrLines(std::vector<int> pickedSeedLabels, vtkSm
 
         //Prepare source and target seeds
         vtkSmartPointer<vtkIdList> inletSeedIds = vtkSmartPointer<vtkIdList>::New();
-        vtkSmartPointer<vtkIdList> outletSeedIds = vtkSmartPointer<vtkIdList>::New();
         inletSeedIds->InsertNextId(CentreOfMass(surface));
 
         MITK_INFO << "Number of pickedSeedLabels: ";
         MITK_INFO << pickedSeedLabels.size();
 
-        for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
+        //The tessellation and Voronoi diagram depend only on the surface,
+        //the first vein builds them and the rest only run the path search
+        int noVeins = pickedSeedLabels.size();
+        std::vector<vtkSmartPointer<vtkvmtkPolyDataCenterlines>> veinLines(noVeins);
+        auto computeLine = [&](int i, vtkUnstructuredGrid* delaunay, vtkPolyData* voronoi, vtkIdList* poleIds) {
+            vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+            input->DeepCopy(surface->GetVtkPolyData());
+            vtkSmartPointer<vtkIdList> sourceSeedIds = vtkSmartPointer<vtkIdList>::New();
+            vtkSmartPointer<vtkIdList> targetSeedIds = vtkSmartPointer<vtkIdList>::New();
+            sourceSeedIds->DeepCopy(inletSeedIds);
+            targetSeedIds->InsertNextId(pickedSeedIds->GetId(i));
 
             //Compute Centre Lines
-            outletSeedIds->InsertNextId(pickedSeedIds->GetId(i));
             vtkSmartPointer<vtkvmtkPolyDataCenterlines> centreLineFilter = vtkSmartPointer<vtkvmtkPolyDataCenterlines>::New();
-            centreLineFilter->SetInputData(surface->GetVtkPolyData());
-            centreLineFilter->SetSourceSeedIds(inletSeedIds);
-            centreLineFilter->SetTargetSeedIds(outletSeedIds);
+            centreLineFilter->SetInputData(input);
+            centreLineFilter->SetSourceSeedIds(sourceSeedIds);
+            centreLineFilter->SetTargetSeedIds(targetSeedIds);
             centreLineFilter->SetRadiusArrayName("MaximumInscribedSphereRadius");
             centreLineFilter->SetCostFunction("1/R");
             centreLineFilter->SetFlipNormals(flip);
@@ -131,8 +147,21 @@ void CemrgAtriaClipper::ComputeCtrLines(std::vector<int> pickedSeedLabels, vtkSm
             centreLineFilter->SetSimplifyVoronoi(0);
             centreLineFilter->SetCenterlineResampling(1);
             centreLineFilter->SetResamplingStepLength(clSpacing);
+            if (voronoi != NULL) {
+                //The filter still reads the tessellation when it is not generated
+                vtkSmartPointer<vtkUnstructuredGrid> delaunayCopy = vtkSmartPointer<vtkUnstructuredGrid>::New();
+                vtkSmartPointer<vtkPolyData> voronoiCopy = vtkSmartPointer<vtkPolyData>::New();
+                vtkSmartPointer<vtkIdList> poleIdsCopy = vtkSmartPointer<vtkIdList>::New();
+                delaunayCopy->DeepCopy(delaunay);
+                voronoiCopy->DeepCopy(voronoi);
+                poleIdsCopy->DeepCopy(poleIds);
+                centreLineFilter->GenerateDelaunayTessellationOff();
+                centreLineFilter->GenerateVoronoiDiagramOff();
+                centreLineFilter->SetDelaunayTessellation(delaunayCopy);
+                centreLineFilter->SetVoronoiDiagram(voronoiCopy);
+                centreLineFilter->SetPoleIds(poleIdsCopy);
+            }//_if
             centreLineFilter->Update();
-            outletSeedIds->DeleteId(pickedSeedIds->GetId(i));
 
             //Centrelines labels
             vtkSmartPointer<vtkIntArray> label = vtkSmartPointer<vtkIntArray>::New();
@@ -140,65 +169,61 @@ void CemrgAtriaClipper::ComputeCtrLines(std::vector<int> pickedSeedLabels, vtkSm
             label->SetName("PickedSeedLabels");
             label->InsertNextValue(pickedSeedLabels.at(i));
             centreLineFilter->GetOutput()->GetFieldData()->AddArray(label);
+            veinLines[i] = centreLineFilter;
+        };
 
-            centreLines.push_back(centreLineFilter);
+        if (noVeins > 0) {
+            computeLine(0, NULL, NULL, NULL);
             mitk::ProgressBar::GetInstance()->Progress();
-        }//_for
+            vtkUnstructuredGrid* delaunay = veinLines[0]->GetDelaunayTessellation();
+            vtkPolyData* voronoi = veinLines[0]->GetVoronoiDiagram();
+            vtkIdList* poleIds = veinLines[0]->GetPoleIds();
+            CemrgJobScheduler::ParallelFor(noVeins-1, [&](int begin, int end) {
+                for (int i=begin; i<end; i++)
+                    computeLine(i+1, delaunay, voronoi, poleIds);
+            });
+            mitk::ProgressBar::GetInstance()->Progress(noVeins-1);
+        }//_if
+        centreLines.insert(centreLines.end(), veinLines.begin(), veinLines.end());
     } else
         mitk::ProgressBar::GetInstance()->Progress(pickedSeedLabels.size());
 }
 
 void CemrgAtriaClipper::ComputeCtrLinesClippers(std::vector<int> pickedSeedLabels) {
 
+    CEMRG_TRACE_SCOPE("CemrgAtriaClipper::ComputeCtrLinesClippers", directory);
+
     //Compute centreline cut points
     manuals.clear();
     normalPlAngles.clear();
     centreLineVeinPlanes.clear();
     centreLinePolyPlanes.clear();
     centreLinePointPlanes.clear();
-    vtkSmartPointer<vtkDoubleArray> areaMeter = vtkSmartPointer<vtkDoubleArray>::New();
+    cutterMasks.clear();
+    cutterDirty.clear();
+    cutterVoxels.clear();
+
+    //Ostium search per centreline, lines are independent
+    std::vector<int> clipPointIDs(pickedSeedLabels.size());
+    CemrgJobScheduler::ParallelFor(pickedSeedLabels.size(), [&](int begin, int end) {
+        vtkSmartPointer<vtkPolyData> surfacePD = vtkSmartPointer<vtkPolyData>::New();
+        surfacePD->DeepCopy(surface->GetVtkPolyData());
+        for (int i=begin; i<end; i++)
+            clipPointIDs[i] = OstiumPosition(surfacePD, centreLines.at(i)->GetOutput());
+    });
 
     for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
 
-        int pointID;
-        double slope;
-        int clipPointID;
-        int highCount = 0;
-        vtkSmartPointer<vtkPolyData> line = centreLines.at(i)->GetOutput();
-        int noBumpCriterion = round(criterion * line->GetNumberOfPoints());
-
         //Initialisation
         manuals.push_back(0);
         std::vector<double> tempVec = {0.0,0.0};
         normalPlAngles.push_back(tempVec);
-
-        //Diameters and area changes
-        vtkSmartPointer<vtkvmtkPolyDataCenterlineSections> ctrLineSects = vtkSmartPointer<vtkvmtkPolyDataCenterlineSections>::New();
-        ctrLineSects->SetInputData(surface->GetVtkPolyData());
-        ctrLineSects->SetCenterlines(line);
-        ctrLineSects->SetCenterlineSectionAreaArrayName("CentrelineSectionAreaArrayName");
-        ctrLineSects->SetCenterlineSectionMinSizeArrayName("CenterlineSectionMinSizeArrayName");
-        ctrLineSects->SetCenterlineSectionMaxSizeArrayName("CenterlineSectionMaxSizeArrayName");
-        ctrLineSects->SetCenterlineSectionShapeArrayName("CenterlineSectionShapeArrayName");
-        ctrLineSects->SetCenterlineSectionClosedArrayName("CenterlineSectionClosedArrayName");
-        ctrLineSects->Update();
-        centreLineVeinPlanes.push_back(ctrLineSects->GetOutput());
-
-        //Slope calculations
-        areaMeter = vtkDoubleArray::SafeDownCast(line->GetPointData()->GetArray("CentrelineSectionAreaArrayName"));
-        for (pointID = 1; pointID<areaMeter->GetNumberOfTuples(); pointID++) {
-            if (areaMeter->GetValue(pointID-1) == 0) continue;
-            slope = areaMeter->GetValue(pointID) - areaMeter->GetValue(pointID-1);
-            slope > highSlope ? highCount += 1 : highCount = 0;
-            if (slope > maxiSlope) break;
-            else if (slope > highSlope && highCount == noBumpCriterion) break;
-        }//_for
-        clipPointID = (highCount == 0) ? pointID - 1 : pointID - highCount;
+        centreLineVeinPlanes.push_back(vtkSmartPointer<vtkPolyData>());
 
         //Create a circle
         vtkSmartPointer<vtkRegularPolygonSource> polygonSource = vtkSmartPointer<vtkRegularPolygonSource>::New();
         polygonSource->SetNumberOfSides(50);
-        CalcParamsOfPlane(polygonSource, i, clipPointID);
+        CalcParamsOfPlane(polygonSource, i, clipPointIDs[i]);
         polygonSource->Update();
         centreLinePolyPlanes.push_back(polygonSource);
         mitk::ProgressBar::GetInstance()->Progress();
@@ -210,6 +235,11 @@ void CemrgAtriaClipper::ComputeCtrLinesClippers(std::vector<int> pickedSeedLabel
 
 void CemrgAtriaClipper::ClipVeinsMesh(std::vector<int> pickedSeedLabels) {
 
+    //Union of all vein cutters, a point is removed when any cutter removes it
+    vtkSmartPointer<vtkImplicitBoolean> implicitCircles = vtkSmartPointer<vtkImplicitBoolean>::New();
+    implicitCircles->SetOperationTypeToUnion();
+    int noCutters = 0;
+
     for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
 
         //Label is not appendage-uncut
@@ -226,310 +256,312 @@ void CemrgAtriaClipper::ClipVeinsMesh(std::vector<int> pickedSeedLabels) {
             implicitCircle->SetOperationTypeToIntersection();
             implicitCircle->AddFunction(plane);
             implicitCircle->AddFunction(sphere);
-            vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
-            clipper->SetClipFunction(implicitCircle);
-            clipper->SetInputData(surface->GetVtkPolyData());
-            clipper->InsideOutOff();
-            clipper->Update();
-
-            //Extract and clean surface mesh
-            vtkSmartPointer<vtkDataSetSurfaceFilter> surfer = vtkSmartPointer<vtkDataSetSurfaceFilter>::New();
-            surfer->SetInputData(clipper->GetOutput());
-            surfer->Update();
-            vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-            cleaner->SetInputConnection(surfer->GetOutputPort());
-            cleaner->Update();
-            vtkSmartPointer<vtkPolyDataConnectivityFilter> lrgRegion = vtkSmartPointer<vtkPolyDataConnectivityFilter>::New();
-            lrgRegion->SetInputConnection(cleaner->GetOutputPort());
-            lrgRegion->SetExtractionModeToLargestRegion();
-            lrgRegion->Update();
-            cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-            cleaner->SetInputConnection(lrgRegion->GetOutputPort());
-            cleaner->Update();
-            clippedSurface->SetVtkPolyData(cleaner->GetOutput());
+            implicitCircles->AddFunction(implicitCircle);
+            noCutters++;
         }//_if
-        mitk::ProgressBar::GetInstance()->Progress();
     }//_for
 
+    if (noCutters > 0) {
+
+        vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
+        clipper->SetClipFunction(implicitCircles);
+        clipper->SetInputData(surface->GetVtkPolyData());
+        clipper->InsideOutOff();
+        clipper->Update();
+
+        //Extract and clean surface mesh
+        vtkSmartPointer<vtkDataSetSurfaceFilter> surfer = vtkSmartPointer<vtkDataSetSurfaceFilter>::New();
+        surfer->SetInputData(clipper->GetOutput());
+        surfer->Update();
+        vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+        cleaner->SetInputConnection(surfer->GetOutputPort());
+        cleaner->Update();
+        vtkSmartPointer<vtkPolyDataConnectivityFilter> lrgRegion = vtkSmartPointer<vtkPolyDataConnectivityFilter>::New();
+        lrgRegion->SetInputConnection(cleaner->GetOutputPort());
+        lrgRegion->SetExtractionModeToLargestRegion();
+        lrgRegion->Update();
+        cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+        cleaner->SetInputConnection(lrgRegion->GetOutputPort());
+        cleaner->Update();
+        clippedSurface->SetVtkPolyData(cleaner->GetOutput());
+    }//_if
+    mitk::ProgressBar::GetInstance()->Progress(pickedSeedLabels.size());
+
     //Save clipped mesh
     QString path = directory + mitk::IOUtil::GetDirectorySeparator() + "segmentation.vtk";
     mitk::IOUtil::Save(clippedSurface, path.toStdString());
+
+    //Queued producibility files are complete once the clip returns
+    CemrgProvenance::Flush();
 }
 
 void CemrgAtriaClipper::ClipVeinsImage(std::vector<int> pickedSeedLabels, mitk::Image::Pointer segImage, bool morphAnalysis) {
 
+    CEMRG_TRACE_SCOPE("CemrgAtriaClipper::ClipVeinsImage", directory);
+
     //Type definitions for new cut seg images
     typedef itk::Image<short, 3> ImageType;
     typedef itk::ImageRegionIteratorWithIndex<ImageType> ItType;
-    typedef itk::SubtractImageFilter<ImageType, ImageType, ImageType> SubtractFilterType;
-    typedef itk::BinaryBallStructuringElement<ImageType::PixelType, 3> BallType;
-    typedef itk::GrayscaleDilateImageFilter<ImageType, ImageType, BallType> DilationFilterType;
     typedef itk::ImageDuplicator<ImageType> DuplicatorType;
 
-    //Cast Seg to ITK formats
-    ImageType::Pointer segItkImage = ImageType::New();
-    CastToItkImage(segImage, segItkImage);
-    ImageType::Pointer orgSegItkImage = ImageType::New();
-    CastToItkImage(segImage, orgSegItkImage);
-    ImageType::Pointer pvLblsItkImage = ImageType::New();
-    CastToItkImage(segImage, pvLblsItkImage);
-    std::vector<ImageType::Pointer> cutRegions;
+    //Cuts of the last clip are reused unless the segmentation, the veins or the cutters set changed
+    bool reclip = cutterMasksImage == segImage && cutterMasksTime == segImage->GetMTime() &&
+            cutterLabels == pickedSeedLabels && cutterVoxels.size() == pickedSeedLabels.size() &&
+            cutterMasks.size() == pickedSeedLabels.size();
+    if (!reclip) {
+        //Cast Seg to ITK formats, cuts are applied in place on private copies
+        cutOrgItkImage = ImageType::New();
+        CastToItkImage(segImage, cutOrgItkImage);
+        DuplicatorType::Pointer duplicator = DuplicatorType::New();
+        duplicator->SetInputImage(cutOrgItkImage);
+        duplicator->Update();
+        cutSegItkImage = duplicator->GetOutput();
+        duplicator = DuplicatorType::New();
+        duplicator->SetInputImage(cutOrgItkImage);
+        duplicator->Update();
+        cutLblItkImage = duplicator->GetOutput();
+        cutOrgRuns.SetImage(cutOrgItkImage);
+        cutterMasks.assign(pickedSeedLabels.size(), ImageType::Pointer());
+        cutterDirty.assign(pickedSeedLabels.size(), true);
+        cutterVoxels.assign(pickedSeedLabels.size(), std::vector<ImageType::OffsetValueType>());
+        cutterLabels = pickedSeedLabels;
+        cutterMasksImage = segImage;
+        cutterMasksTime = segImage->GetMTime();
+    }//_if
+    std::vector<int> dirtyCutters;
+    for (unsigned int i=0; i<pickedSeedLabels.size(); i++)
+        if (cutterDirty[i])
+            dirtyCutters.push_back(i);
 
-    for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
+    //Vein sections at the cutter centres, shared by the morphology and the automatic cutters
+    std::vector<bool> needSections(pickedSeedLabels.size(), morphAnalysis);
+    for (unsigned int j=0; j<dirtyCutters.size(); j++)
+        if (manuals[dirtyCutters[j]] == 0)
+            needSections[dirtyCutters[j]] = true;
+    std::vector<vtkSmartPointer<vtkPolyData>> veinSections = CutterSections(needSections);
 
-        //Find the right vein section by removing unwanted ones
-        vtkSmartPointer<vtkPolyData> line = centreLines.at(i)->GetOutput();
-        int position = line->FindPoint(centreLinePolyPlanes.at(i)->GetCenter());
-        vtkSmartPointer<vtkPolyData> centreVeinPlane = centreLineVeinPlanes.at(i);
-        centreVeinPlane->BuildLinks();
-        for (vtkIdType cellID = 0; cellID < centreVeinPlane->GetNumberOfCells(); cellID++)
-            if (cellID != line->GetNumberOfPoints()-1-position)
-                centreVeinPlane->DeleteCell(cellID);
-        centreVeinPlane->RemoveDeletedCells();
-        vtkSmartPointer<vtkCleanPolyData> cleanPolyData = vtkSmartPointer<vtkCleanPolyData>::New();
-        cleanPolyData->SetInputData(centreVeinPlane);
-        cleanPolyData->Update();
-        centreVeinPlane = cleanPolyData->GetOutput();
-
-        //Morphological Analysis
-        if (morphAnalysis) {
-
-            int noPV = pickedSeedLabels.size();
-            vtkSmartPointer<vtkDoubleArray> areas = vtkSmartPointer<vtkDoubleArray>::New();
-            areas = vtkDoubleArray::SafeDownCast(line->GetPointData()->GetArray("CentrelineSectionAreaArrayName"));
-            double area = areas->GetValue(position);
-            std::vector <std::tuple<double, double, double>> points;
-            for(vtkIdType i=0; i<centreVeinPlane->GetNumberOfPoints(); i++) {
-                double p[3];
-                centreVeinPlane->GetPoints()->GetPoint(i,p);
-                points.push_back(std::tuple<double, double, double>(p[0],p[1],p[2]));
-            }//_for
-            std::unique_ptr<CemrgMeasure> morphAnal = std::unique_ptr<CemrgMeasure>(new CemrgMeasure());
-            double circ = morphAnal->CalcPerimeter(points);
-            vtkSmartPointer<vtkDoubleArray> diams = vtkSmartPointer<vtkDoubleArray>::New();
-            diams = vtkDoubleArray::SafeDownCast(line->GetPointData()->GetArray("CenterlineSectionMinSizeArrayName"));
-            double diam = diams->GetValue(position);
-
-            ofstream morphResult;
-            QString morphPath = directory + mitk::IOUtil::GetDirectorySeparator() + "morphResults.txt";
-            morphResult.open(morphPath.toStdString(), std::ios_base::app);
-            if (i == 0)
-                morphResult << "NO " << --noPV << "\n";
-            morphResult << pickedSeedLabels.at(i) << " " << area << "\n";
-            morphResult << pickedSeedLabels.at(i) << " " << circ << "\n";
-            morphResult << pickedSeedLabels.at(i) << " " << diam << "\n";
-            morphResult.close();
-        }//_if
+    //Morphological Analysis
+    if (morphAnalysis)
+        ComputeMorphology(pickedSeedLabels, veinSections);
+
+    //Only adjusted cutters are rebuilt
+    std::vector<vtkSmartPointer<vtkPolyData>> cutters(pickedSeedLabels.size());
+    for (unsigned int j=0; j<dirtyCutters.size(); j++) {
+
+        int i = dirtyCutters[j];
+        vtkSmartPointer<vtkPolyData> veinSection = veinSections[i];
 
         //Flip the cutter plane
         vtkSmartPointer<vtkPolyData> circle;
         if (manuals[i] == 2) {
             vtkSmartPointer<vtkPolygon> polygon = vtkSmartPointer<vtkPolygon>::New();
             polygon->GetPointIds()->SetNumberOfIds(centreLinePointPlanes.at(i)->GetNumberOfPoints());
-            for (int j=0; j<centreLinePointPlanes.at(i)->GetNumberOfPoints(); j++)
-                polygon->GetPointIds()->SetId(j,j);
+            for (int k=0; k<centreLinePointPlanes.at(i)->GetNumberOfPoints(); k++)
+                polygon->GetPointIds()->SetId(k,k);
             vtkSmartPointer<vtkCellArray> polygons = vtkSmartPointer<vtkCellArray>::New();
             polygons->InsertNextCell(polygon);
+            vtkSmartPointer<vtkPoints> polygonPoints = vtkSmartPointer<vtkPoints>::New();
+            polygonPoints->DeepCopy(centreLinePointPlanes.at(i));
             vtkSmartPointer<vtkPolyData> polygonPolyData = vtkSmartPointer<vtkPolyData>::New();
-            polygonPolyData->SetPoints(centreLinePointPlanes.at(i));
+            polygonPolyData->SetPoints(polygonPoints);
             polygonPolyData->SetPolys(polygons);
             circle = polygonPolyData;
             QString path = directory + mitk::IOUtil::GetDirectorySeparator() + "manualType2Clipper.vtk";
-            vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-            writer->SetInputData(circle);
-            writer->SetFileName(path.toStdString().c_str());
-            writer->Write();
-        } else if (manuals[i] == 1)
-            circle = centreLinePolyPlanes.at(i)->GetOutput();
-        else
-            circle = centreLineVeinPlanes.at(i);
-        for (int i=0; i<circle->GetNumberOfPoints(); i++) {
-            double* point = circle->GetPoint(i);
+            CemrgProvenance::WritePolyData(circle, path);
+        } else if (manuals[i] == 1) {
+            circle = vtkSmartPointer<vtkPolyData>::New();
+            circle->DeepCopy(centreLinePolyPlanes.at(i)->GetOutput());
+        } else
+            circle = veinSection;
+        for (int k=0; k<circle->GetNumberOfPoints(); k++) {
+            double* point = circle->GetPoint(k);
             point[0] = -point[0];
             point[1] = -point[1];
-            circle->GetPoints()->SetPoint(i, point);
+            circle->GetPoints()->SetPoint(k, point);
         }//_for
 
         /*
          * Producibility Test
          **/
-        try {
+        if (CemrgProvenance::IsEnabled()) {
             QString prodPath = directory + mitk::IOUtil::GetDirectorySeparator();
-            mitk::Surface::Pointer prodSurf = mitk::Surface::New();
-            prodSurf->SetVtkPolyData(circle);
-            mitk::IOUtil::Save(prodSurf, (prodPath + "prodCutter" + QString::number(i) + ".vtk").toStdString());
-            ofstream prodFile1;
-            prodFile1.open((prodPath + "prodCutter" + QString::number(i) + "TNormals.txt").toStdString());
+            CemrgProvenance::WritePolyData(circle, prodPath + "prodCutter" + QString::number(i) + ".vtk");
+            std::ostringstream prodFile1;
             prodFile1 << centreLinePolyPlanes.at(i)->GetNormal()[0] << "\n";
             prodFile1 << centreLinePolyPlanes.at(i)->GetNormal()[1] << "\n";
             prodFile1 << centreLinePolyPlanes.at(i)->GetNormal()[2] << "\n";
             prodFile1 << manuals[i] << "\n";
-            prodFile1.close();
-        } catch(...) {};
+            CemrgProvenance::WriteText(prodPath + "prodCutter" + QString::number(i) + "TNormals.txt", prodFile1.str());
+        }//_if
         /*
          * End Test
          **/
 
-        //Prepare empty image
-        vtkSmartPointer<vtkImageData> whiteImage = vtkSmartPointer<vtkImageData>::New();
-        double spacing[3];
-        segImage->GetVtkImageData()->GetSpacing(spacing);
-        whiteImage->SetSpacing(spacing);
-        int dimensions[3];
-        segImage->GetVtkImageData()->GetDimensions(dimensions);
-        whiteImage->SetDimensions(dimensions);
-        whiteImage->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
-        double origin[3];
-        segImage->GetGeometry()->GetOrigin().ToArray(origin);
-        whiteImage->SetOrigin(origin);
-        whiteImage->AllocateScalars(VTK_UNSIGNED_CHAR,1);
-        unsigned char otval = 0;
-        unsigned char inval = 255;
-        vtkIdType count = whiteImage->GetNumberOfPoints();
-        for (vtkIdType i = 0; i < count; ++i)
-            whiteImage->GetPointData()->GetScalars()->SetTuple1(i, inval);
-
-        //Sweep polygonal data to create an image
-        vtkSmartPointer<vtkLinearExtrusionFilter> extruder = vtkSmartPointer<vtkLinearExtrusionFilter>::New();
-        extruder->SetInputData(circle);
-        extruder->SetScaleFactor(1.0);
-        extruder->SetExtrusionTypeToNormalExtrusion();
-        extruder->SetVector(centreLinePolyPlanes.at(i)->GetNormal());
-        extruder->Update();
-        vtkSmartPointer<vtkPolyDataToImageStencil> pol2stenc = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
-        pol2stenc->SetTolerance(0.5);
-        pol2stenc->SetInputConnection(extruder->GetOutputPort());
-        pol2stenc->SetOutputOrigin(origin);
-        pol2stenc->SetOutputSpacing(spacing);
-        pol2stenc->SetOutputWholeExtent(whiteImage->GetExtent());
-        pol2stenc->Update();
-        vtkSmartPointer<vtkImageStencil> imgstenc = vtkSmartPointer<vtkImageStencil>::New();
-        imgstenc->SetInputData(whiteImage);
-        imgstenc->SetStencilConnection(pol2stenc->GetOutputPort());
-        imgstenc->ReverseStencilOff();
-        imgstenc->SetBackgroundValue(otval);
-        imgstenc->Update();
-
-        //VTK to ITK conversion
-        mitk::Image::Pointer cutImg = mitk::Image::New();
-        cutImg->Initialize(imgstenc->GetOutput());
-        cutImg->SetVolume(imgstenc->GetOutput()->GetScalarPointer());
-        ImageType::Pointer cutItkImage = ImageType::New();
-        CastToItkImage(cutImg, cutItkImage);
-        itk::ResampleImageFilter<ImageType, ImageType>::Pointer resampleFilter;
-        resampleFilter = itk::ResampleImageFilter<ImageType, ImageType >::New();
-        resampleFilter->SetInput(cutItkImage);
-        resampleFilter->SetReferenceImage(segItkImage);
-        resampleFilter->SetUseReferenceImage(true);
-        resampleFilter->SetInterpolator(itk::NearestNeighborInterpolateImageFunction<ImageType>::New());
-        resampleFilter->SetDefaultPixelValue(0);
-        resampleFilter->UpdateLargestPossibleRegion();
-        cutItkImage = resampleFilter->GetOutput();
-
-        //Image Dilation
-        BallType binaryBall;
-        binaryBall.SetRadius(manuals[i] == 1 ? static_cast<unsigned long>(1.0) : static_cast<unsigned long>(1.5));
-        binaryBall.CreateStructuringElement();
-        DilationFilterType::Pointer dilationFilter = DilationFilterType::New();
-        dilationFilter->SetInput(cutItkImage);
-        dilationFilter->SetKernel(binaryBall);
-        dilationFilter->UpdateLargestPossibleRegion();
-        cutImg = mitk::ImportItkImage(dilationFilter->GetOutput())->Clone();
-        CastToItkImage(cutImg, cutItkImage);
-
-        //Subtract images
-        SubtractFilterType::Pointer subFilter = SubtractFilterType::New();
-        subFilter->SetInput1(segItkImage);
-        subFilter->SetInput2(cutItkImage);
-        subFilter->UpdateLargestPossibleRegion();
-
-        //Duplicate subtract images
-        DuplicatorType::Pointer duplicator = DuplicatorType::New();
-        duplicator->SetInputImage(subFilter->GetOutput());
-        duplicator->Update();
-        cutRegions.push_back(duplicator->GetOutput());
-
-        //Record voxel locations before cut
-        ItType itSub(subFilter->GetOutput(), subFilter->GetOutput()->GetRequestedRegion());
-        ItType itLbl(pvLblsItkImage, pvLblsItkImage->GetRequestedRegion());
-        itLbl.GoToBegin();
-        for (itSub.GoToBegin(); !itSub.IsAtEnd(); ++itSub) {
-            if ((int)itSub.Get() == -254 || (int)itSub.Get() == -255) {
-                if (pickedSeedLabels.at(i) == APPENDAGEUNCUT && (int)itSub.Get() == -255)
-                    itSub.Set(0);
-                if (pickedSeedLabels.at(i) != APPENDAGEUNCUT)
-                    itSub.Set(0);
-                itLbl.Set(0);
+        cutters[i] = circle;
+    }//_for
+
+    //Cutter masks are independent, rebuild the changed ones concurrently
+    std::vector<ImageType::Pointer> staleMasks(cutterMasks);
+    CemrgJobScheduler::ParallelFor(dirtyCutters.size(), [&](int begin, int end) {
+        for (int j=begin; j<end; j++) {
+            int i = dirtyCutters[j];
+            cutterMasks[i] = CutterMask(
+                        cutters[i], centreLinePolyPlanes.at(i)->GetNormal(), cutOrgItkImage,
+                        manuals[i] == 1 ? static_cast<unsigned long>(1.0) : static_cast<unsigned long>(1.5));
+        }//_for
+    });
+    for (unsigned int j=0; j<dirtyCutters.size(); j++)
+        cutterDirty[dirtyCutters[j]] = false;
+
+    //Cut of one voxel by cutter i, the first cut only removes label 1
+    ImageType::PixelType* org = cutOrgItkImage->GetBufferPointer();
+    ImageType::PixelType* seg = cutSegItkImage->GetBufferPointer();
+    ImageType::PixelType* lbl = cutLblItkImage->GetBufferPointer();
+    auto cutVoxel = [&](unsigned int i, ImageType::OffsetValueType offset) {
+        bool inSeg = (i == 0) ? seg[offset] == 1 : seg[offset] != 0;
+        if (inSeg) {
+            cutterVoxels[i].push_back(offset);
+            if (pickedSeedLabels.at(i) != APPENDAGEUNCUT)
+                seg[offset] = 0;
+        }//_if
+        if (inSeg || seg[offset] == 0)
+            lbl[offset] = 0;
+    };
+
+    if (!reclip) {
+
+        //Merge in picking order so the result matches a serial cut
+        for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
+            ImageType::Pointer cutItkImage = cutterMasks[i];
+            if (cutItkImage) {
+                ItType itCut(cutItkImage, cutItkImage->GetLargestPossibleRegion());
+                for (itCut.GoToBegin(); !itCut.IsAtEnd(); ++itCut)
+                    if (itCut.Get() != 0)
+                        cutVoxel(i, cutOrgItkImage->ComputeOffset(itCut.GetIndex()));
             }//_if
-            ++itLbl;
         }//_for
 
-        //Relabel the components
-        typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentImageFilterType;
-        ConnectedComponentImageFilterType::Pointer connected = ConnectedComponentImageFilterType::New();
-        connected->SetInput(subFilter->GetOutput());
-        connected->Update();
-        typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelFilterType;
-        RelabelFilterType::Pointer relabeler = RelabelFilterType::New();
-        relabeler->SetInput(connected->GetOutput());
-        relabeler->Update();
-
-        //Keep the single largest component
-        typedef itk::LabelShapeKeepNObjectsImageFilter<ImageType> LabelShapeKeepNObjImgFilterType;
-        LabelShapeKeepNObjImgFilterType::Pointer lblShpKpNObjImgFltr = LabelShapeKeepNObjImgFilterType::New();
-        lblShpKpNObjImgFltr->SetInput(relabeler->GetOutput());
-        lblShpKpNObjImgFltr->SetBackgroundValue(0);
-        lblShpKpNObjImgFltr->SetNumberOfObjects(1);
-        lblShpKpNObjImgFltr->SetAttribute(LabelShapeKeepNObjImgFilterType::LabelObjectType::NUMBER_OF_PIXELS);
-        lblShpKpNObjImgFltr->Update();
-
-        segItkImage = lblShpKpNObjImgFltr->GetOutput();
-        mitk::ProgressBar::GetInstance()->Progress();
-    }//_for
+    } else if (!dirtyCutters.empty()) {
+
+        //Only voxels under the old or new mask of an adjusted cutter can change
+        std::vector<ImageType::OffsetValueType> redo;
+        for (unsigned int j=0; j<dirtyCutters.size(); j++) {
+            ImageType::Pointer masks[2] = {staleMasks[dirtyCutters[j]], cutterMasks[dirtyCutters[j]]};
+            for (int m=0; m<2; m++) {
+                if (masks[m].IsNull())
+                    continue;
+                ItType itCut(masks[m], masks[m]->GetLargestPossibleRegion());
+                for (itCut.GoToBegin(); !itCut.IsAtEnd(); ++itCut)
+                    if (itCut.Get() != 0)
+                        redo.push_back(cutOrgItkImage->ComputeOffset(itCut.GetIndex()));
+            }//_for
+        }//_for
+        std::sort(redo.begin(), redo.end());
+        redo.erase(std::unique(redo.begin(), redo.end()), redo.end());
+
+        //Undo the contributions of all cutters there
+        for (unsigned int i=0; i<cutterVoxels.size(); i++) {
+            std::vector<ImageType::OffsetValueType>& voxels = cutterVoxels[i];
+            voxels.erase(std::remove_if(voxels.begin(), voxels.end(), [&](ImageType::OffsetValueType offset) {
+                return std::binary_search(redo.begin(), redo.end(), offset);
+            }), voxels.end());
+        }//_for
+
+        //Replay the serial cut voxel by voxel
+        for (size_t j=0; j<redo.size(); j++) {
+            ImageType::OffsetValueType offset = redo[j];
+            ImageType::IndexType index = cutOrgItkImage->ComputeIndex(offset);
+            seg[offset] = org[offset];
+            lbl[offset] = org[offset];
+            for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
+                ImageType::Pointer cutItkImage = cutterMasks[i];
+                if (cutItkImage && cutItkImage->GetBufferedRegion().IsInside(index) && cutItkImage->GetPixel(index) != 0)
+                    cutVoxel(i, offset);
+            }//_for
+        }//_for
+    }//_if
+    mitk::ProgressBar::GetInstance()->Progress(pickedSeedLabels.size());
+
+    //Keep the single largest component once all veins are cut
+    ImageType::Pointer segItkImage;
+    if (pickedSeedLabels.size() > 0) {
+        segItkImage = CemrgConnectedComponents(cutSegItkImage).GetLabelledImage(1);
+    } else {
+        DuplicatorType::Pointer duplicator = DuplicatorType::New();
+        duplicator->SetInputImage(cutSegItkImage);
+        duplicator->Update();
+        segItkImage = duplicator->GetOutput();
+    }//_if
 
     //Label individual veins
-    typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentImageFilterType;
-    ConnectedComponentImageFilterType::Pointer connected = ConnectedComponentImageFilterType::New();
-    connected->SetInput(pvLblsItkImage);
-    connected->Update();
-    typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelFilterType;
-    RelabelFilterType::Pointer relabeler = RelabelFilterType::New();
-    relabeler->SetInput(connected->GetOutput());
-    relabeler->Update();
-    pvLblsItkImage = relabeler->GetOutput();
-
-    //Adjust voxel labels after cut MV
-    ItType itCut(segItkImage, segItkImage->GetRequestedRegion());
-    ItType itLbl(pvLblsItkImage, pvLblsItkImage->GetRequestedRegion());
-    ItType itOrg(orgSegItkImage, orgSegItkImage->GetRequestedRegion());
-    itCut.GoToBegin();
-    itLbl.GoToBegin();
-    for (itOrg.GoToBegin(); !itOrg.IsAtEnd(); ++itOrg) {
-        //MV labels
-        if ((int)itOrg.Get() == 2) {
-            itCut.Set(2);
-            itLbl.Set(10);
+    ImageType::Pointer pvLblsItkImage = CemrgConnectedComponents(cutLblItkImage).GetLabelledImage();
+
+    //Cut voxels reaching the kept component through other cut voxels, cuts of discarded fragments stay out
+    seg = segItkImage->GetBufferPointer();
+    lbl = pvLblsItkImage->GetBufferPointer();
+    std::vector<ImageType::OffsetValueType> cutOffsets;
+    for (unsigned int i=0; i<cutterVoxels.size(); i++)
+        cutOffsets.insert(cutOffsets.end(), cutterVoxels.at(i).begin(), cutterVoxels.at(i).end());
+    std::sort(cutOffsets.begin(), cutOffsets.end());
+    cutOffsets.erase(std::unique(cutOffsets.begin(), cutOffsets.end()), cutOffsets.end());
+    std::vector<char> cutJoined(cutOffsets.size(), 0);
+    std::vector<size_t> front;
+    const ImageType::OffsetValueType* strides = segItkImage->GetOffsetTable();
+    ImageType::SizeType size = segItkImage->GetLargestPossibleRegion().GetSize();
+    auto visitNeighbours = [&](size_t j, bool seed) {
+        ImageType::IndexType index = segItkImage->ComputeIndex(cutOffsets[j]);
+        for (int a=0; a<3; a++) {
+            for (int step=-1; step<=1; step+=2) {
+                if (index[a] + step < 0 || index[a] + step >= (ImageType::IndexValueType)size[a])
+                    continue;
+                ImageType::OffsetValueType neighbour = cutOffsets[j] + step * strides[a];
+                if (seed) {
+                    if (seg[neighbour] != 0)
+                        return true;
+                    continue;
+                }//_if
+                auto it = std::lower_bound(cutOffsets.begin(), cutOffsets.end(), neighbour);
+                if (it != cutOffsets.end() && *it == neighbour && !cutJoined[it - cutOffsets.begin()]) {
+                    cutJoined[it - cutOffsets.begin()] = 1;
+                    front.push_back(it - cutOffsets.begin());
+                }//_if
+            }//_for
+        }//_for
+        return false;
+    };
+    for (size_t j=0; j<cutOffsets.size(); j++) {
+        if (seg[cutOffsets[j]] != 0 || visitNeighbours(j, true)) {
+            cutJoined[j] = 1;
+            front.push_back(j);
         }//_if
-        ++itCut;
-        ++itLbl;
+    }//_for
+    while (!front.empty()) {
+        size_t j = front.back();
+        front.pop_back();
+        visitNeighbours(j, false);
+    }//_while
+
+    //Adjust voxel labels after cut MV, only the MV runs of the original seg are visited
+    const std::vector<CemrgRunLengthImage::Run>& orgRuns = cutOrgRuns.GetRuns();
+    for (size_t j=0; j<orgRuns.size(); j++) {
+        //MV labels
+        if (orgRuns[j].label != 2)
+            continue;
+        ImageType::OffsetValueType offset = cutOrgRuns.GetOffset(orgRuns[j]);
+        std::fill(seg + offset, seg + offset + orgRuns[j].length, 2);
+        std::fill(lbl + offset, lbl + offset + orgRuns[j].length, 10);
     }//_for
 
     //Adjust voxel labels after cut PV
     for (unsigned int i=0; i<pickedSeedLabels.size(); i++) {
-        ItType itCutSub(segItkImage, segItkImage->GetRequestedRegion());
-        ItType itLblSub(pvLblsItkImage, pvLblsItkImage->GetRequestedRegion());
-        ItType itOrgSub(cutRegions.at(i), cutRegions.at(i)->GetRequestedRegion());
-        itCutSub.GoToBegin();
-        itLblSub.GoToBegin();
-        for (itOrgSub.GoToBegin(); !itOrgSub.IsAtEnd(); ++itOrgSub) {
+        for (size_t j=0; j<cutterVoxels.at(i).size(); j++) {
             //PV labels
-            if ((int)itOrgSub.Get() == -254) {
-                if (pickedSeedLabels.at(i) != APPENDAGEUNCUT)
-                    itCutSub.Set(3);
-                itLblSub.Set(pickedSeedLabels.at(i));
-            }//_if
-            ++itCutSub;
-            ++itLblSub;
+            ImageType::OffsetValueType offset = cutterVoxels.at(i).at(j);
+            if (!cutJoined[std::lower_bound(cutOffsets.begin(), cutOffsets.end(), offset) - cutOffsets.begin()])
+                continue;
+            if (pickedSeedLabels.at(i) != APPENDAGEUNCUT)
+                seg[offset] = 3;
+            lbl[offset] = pickedSeedLabels.at(i);
         }//_for
     }//_for
 
@@ -546,6 +578,78 @@ void CemrgAtriaClipper::ClipVeinsImage(std::vector<int> pickedSeedLabels, mitk::
     mitk::Image::Pointer pvCropped = mitk::ImportItkImage(segItkImage)->Clone();
     mitk::IOUtil::Save(pvCropped, path.toStdString());
     clippedSegImage = pvCropped;
+
+    //Queued producibility files are complete once the clip returns
+    CemrgProvenance::Flush();
+}
+
+void CemrgAtriaClipper::ComputeMorphology(std::vector<int> pickedSeedLabels) {
+
+    ComputeMorphology(pickedSeedLabels, CutterSections(std::vector<bool>(pickedSeedLabels.size(), true)));
+}
+
+void CemrgAtriaClipper::ComputeMorphology(std::vector<int> pickedSeedLabels, std::vector<vtkSmartPointer<vtkPolyData>> veinSections) {
+
+    CEMRG_TRACE_SCOPE("CemrgAtriaClipper::ComputeMorphology", directory);
+
+    //Ostial section metrics at each cutter centre, veins are independent
+    int noPV = pickedSeedLabels.size();
+    std::vector<std::vector<double>> metrics(noPV);
+    CemrgJobScheduler::ParallelFor(noPV, [&](int begin, int end) {
+        for (int i=begin; i<end; i++) {
+
+            vtkSmartPointer<vtkPolyData> line = centreLines.at(i)->GetOutput();
+            int position = line->FindPoint(centreLinePolyPlanes.at(i)->GetCenter());
+            vtkSmartPointer<vtkPolyData> section = veinSections.at(i);
+            vtkSmartPointer<vtkCleanPolyData> cleanPolyData = vtkSmartPointer<vtkCleanPolyData>::New();
+            cleanPolyData->SetInputData(section);
+            cleanPolyData->Update();
+            vtkSmartPointer<vtkPoints> points = cleanPolyData->GetOutput()->GetPoints();
+
+            //Open chain as CemrgMeasure::CalcPerimeter, closed polygon for the table
+            double chain = -1, perimeter = 0;
+            vtkIdType noPoints = points == NULL ? 0 : points->GetNumberOfPoints();
+            if (noPoints >= 3) {
+                chain = 0;
+                for (vtkIdType j=0; j<noPoints-1; j++)
+                    chain += sqrt(vtkMath::Distance2BetweenPoints(points->GetPoint(j), points->GetPoint(j+1)));
+                perimeter = chain + sqrt(vtkMath::Distance2BetweenPoints(points->GetPoint(noPoints-1), points->GetPoint(0)));
+            }//_if
+
+            double point[3], sizeRange[2] = {0.0, 0.0}, area = 0.0;
+            line->GetPoint(position, point);
+            if (section->GetNumberOfCells() > 0) {
+                area = vtkvmtkPolyDataBranchSections::ComputeBranchSectionArea(section);
+                vtkvmtkPolyDataBranchSections::ComputeBranchSectionShape(section, point, sizeRange);
+            }//_if
+            double eccentricity = sizeRange[1] > 0 ? sqrt(std::max(0.0, 1.0 - pow(sizeRange[0] / sizeRange[1], 2))) : 0.0;
+            metrics[i] = {area, chain, sizeRange[0], perimeter, sizeRange[1], eccentricity};
+        }//_for
+    });
+
+    //Legacy results file, area circumference and diameter per vein
+    ofstream morphResult;
+    QString morphPath = directory + mitk::IOUtil::GetDirectorySeparator() + "morphResults.txt";
+    morphResult.open(morphPath.toStdString(), std::ios_base::app);
+    if (noPV > 0)
+        morphResult << "NO " << noPV-1 << "\n";
+    for (int i=0; i<noPV; i++) {
+        morphResult << pickedSeedLabels.at(i) << " " << metrics[i][0] << "\n";
+        morphResult << pickedSeedLabels.at(i) << " " << metrics[i][1] << "\n";
+        morphResult << pickedSeedLabels.at(i) << " " << metrics[i][2] << "\n";
+    }//_for
+    morphResult.close();
+
+    //One row per vein
+    ofstream morphTable;
+    QString tablePath = directory + mitk::IOUtil::GetDirectorySeparator() + "morphVeinsTable.csv";
+    morphTable.open(tablePath.toStdString());
+    morphTable << "label,area,perimeter,minDiameter,maxDiameter,eccentricity\n";
+    for (int i=0; i<noPV; i++) {
+        morphTable << pickedSeedLabels.at(i) << "," << metrics[i][0] << "," << metrics[i][3] << ",";
+        morphTable << metrics[i][2] << "," << metrics[i][4] << "," << metrics[i][5] << "\n";
+    }//_for
+    morphTable.close();
 }
 
 void CemrgAtriaClipper::CalcParamsOfPlane(vtkSmartPointer<vtkRegularPolygonSource> plane, int ctrLineNo, int position) {
@@ -588,6 +692,7 @@ void CemrgAtriaClipper::CalcParamsOfPlane(vtkSmartPointer<vtkRegularPolygonSourc
     plane->SetCenter(clipPoint);
     plane->SetRadius(clipRadius);
     plane->SetNormal(clipNormal);
+    SetCutterModified(ctrLineNo);
 }
 
 void CemrgAtriaClipper::ResetCtrLinesClippingPlanes() {
@@ -595,6 +700,237 @@ void CemrgAtriaClipper::ResetCtrLinesClippingPlanes() {
     centreLineVeinPlanes.clear();
     centreLinePolyPlanes.clear();
     centreLinePointPlanes.clear();
+    cutterMasks.clear();
+    cutterDirty.clear();
+    cutterVoxels.clear();
+}
+
+vtkSmartPointer<vtkPolyData> CemrgAtriaClipper::CentreLineSection(vtkPolyData* surfacePD, vtkPolyData* line, int position) {
+
+    //Tangent as in vtkvmtkPolyDataCenterlineSections
+    double point[3], tangent[3] = {0.0, 0.0, 0.0};
+    line->GetPoint(position, point);
+    for (int neighbour=position-1; neighbour<=position+1; neighbour+=2) {
+        if (neighbour < 0 || neighbour >= line->GetNumberOfPoints())
+            continue;
+        double other[3];
+        line->GetPoint(neighbour, other);
+        double distance = sqrt(vtkMath::Distance2BetweenPoints(point, other));
+        if (distance == 0.0)
+            continue;
+        double sign = neighbour > position ? 1.0 : -1.0;
+        for (int a=0; a<3; a++)
+            tangent[a] += sign * (other[a] - point[a]) / distance;
+    }//_for
+    vtkMath::Normalize(tangent);
+
+    //Section polygon, area and minimum size written into the line arrays
+    bool closed = false;
+    vtkSmartPointer<vtkPolyData> section = vtkSmartPointer<vtkPolyData>::New();
+    vtkvmtkPolyDataBranchSections::ExtractCylinderSection(surfacePD, point, tangent, section, closed);
+    double area = 0.0, sizeRange[2] = {0.0, 0.0};
+    if (section->GetNumberOfCells() > 0) {
+        section->BuildCells();
+        area = vtkvmtkPolyDataBranchSections::ComputeBranchSectionArea(section);
+        vtkvmtkPolyDataBranchSections::ComputeBranchSectionShape(section, point, sizeRange);
+    }//_if
+
+    const char* names[2] = {"CentrelineSectionAreaArrayName", "CenterlineSectionMinSizeArrayName"};
+    double values[2] = {area, sizeRange[0]};
+    for (int n=0; n<2; n++) {
+        vtkDoubleArray* array = vtkDoubleArray::SafeDownCast(line->GetPointData()->GetArray(names[n]));
+        if (array == NULL || array->GetNumberOfTuples() != line->GetNumberOfPoints()) {
+            vtkSmartPointer<vtkDoubleArray> newArray = vtkSmartPointer<vtkDoubleArray>::New();
+            newArray->SetName(names[n]);
+            newArray->SetNumberOfTuples(line->GetNumberOfPoints());
+            newArray->FillComponent(0, 0.0);
+            line->GetPointData()->AddArray(newArray);
+            array = newArray;
+        }//_if
+        array->SetValue(position, values[n]);
+    }//_for
+    return section;
+}
+
+std::vector<vtkSmartPointer<vtkPolyData>> CemrgAtriaClipper::CutterSections(std::vector<bool> needed) {
+
+    //Sections at the cutter centres, veins are independent
+    std::vector<vtkSmartPointer<vtkPolyData>> sections(needed.size());
+    CemrgJobScheduler::ParallelFor(needed.size(), [&](int begin, int end) {
+        vtkSmartPointer<vtkPolyData> surfacePD;
+        for (int i=begin; i<end; i++) {
+            if (!needed[i])
+                continue;
+            if (!surfacePD) {
+                surfacePD = vtkSmartPointer<vtkPolyData>::New();
+                surfacePD->DeepCopy(surface->GetVtkPolyData());
+            }//_if
+            vtkSmartPointer<vtkPolyData> line = centreLines.at(i)->GetOutput();
+            int position = line->FindPoint(centreLinePolyPlanes.at(i)->GetCenter());
+            sections[i] = CentreLineSection(surfacePD, line, position);
+        }//_for
+    });
+    return sections;
+}
+
+int CemrgAtriaClipper::OstiumPosition(vtkPolyData* surfacePD, vtkPolyData* line) {
+
+    int pointID;
+    double slope;
+    int highCount = 0;
+    int noBumpCriterion = round(criterion * line->GetNumberOfPoints());
+
+    //Sections are evaluated from the tip and only until the ostium is found
+    std::vector<double> areas(line->GetNumberOfPoints(), -1.0);
+    auto areaAt = [&](int position) {
+        if (areas[position] < 0) {
+            CentreLineSection(surfacePD, line, position);
+            vtkDoubleArray* array = vtkDoubleArray::SafeDownCast(line->GetPointData()->GetArray("CentrelineSectionAreaArrayName"));
+            areas[position] = std::max(0.0, array->GetValue(position));
+        }//_if
+        return areas[position];
+    };
+
+    //Slope calculations
+    for (pointID = 1; pointID<line->GetNumberOfPoints(); pointID++) {
+        if (areaAt(pointID-1) == 0) continue;
+        slope = areaAt(pointID) - areaAt(pointID-1);
+        slope > highSlope ? highCount += 1 : highCount = 0;
+        if (slope > maxiSlope) break;
+        else if (slope > highSlope && highCount == noBumpCriterion) break;
+    }//_for
+    return (highCount == 0) ? pointID - 1 : pointID - highCount;
+}
+
+itk::Image<short,3>::Pointer CemrgAtriaClipper::CutterMask(
+        vtkSmartPointer<vtkPolyData> circle, double* normal, itk::Image<short,3>::Pointer segItkImage, unsigned long radius) {
+
+    typedef itk::Image<short,3> ImageType;
+    typedef itk::BinaryBallStructuringElement<ImageType::PixelType, 3> BallType;
+    typedef itk::GrayscaleDilateImageFilter<ImageType, ImageType, BallType> DilationFilterType;
+    const int pad = 2;
+
+    //Stencil lattice: image origin and spacing with identity axes
+    double origin[3], spacing[3];
+    int dimensions[3];
+    for (int a=0; a<3; a++) {
+        origin[a] = segItkImage->GetOrigin()[a];
+        spacing[a] = segItkImage->GetSpacing()[a];
+        dimensions[a] = segItkImage->GetLargestPossibleRegion().GetSize()[a];
+    }//_for
+
+    //Sweep polygonal data to create an image
+    vtkSmartPointer<vtkLinearExtrusionFilter> extruder = vtkSmartPointer<vtkLinearExtrusionFilter>::New();
+    extruder->SetInputData(circle);
+    extruder->SetScaleFactor(1.0);
+    extruder->SetExtrusionTypeToNormalExtrusion();
+    extruder->SetVector(normal);
+    extruder->Update();
+
+    //Extent of the swept disc only
+    double bounds[6];
+    int extent[6];
+    extruder->GetOutput()->GetBounds(bounds);
+    for (int a=0; a<3; a++) {
+        extent[2*a] = std::max(0, (int)std::floor((bounds[2*a] - origin[a]) / spacing[a]) - pad);
+        extent[2*a+1] = std::min(dimensions[a]-1, (int)std::ceil((bounds[2*a+1] - origin[a]) / spacing[a]) + pad);
+        if (extent[2*a] > extent[2*a+1])
+            return NULL;
+    }//_for
+
+    //Prepare white image of the region
+    vtkSmartPointer<vtkImageData> whiteImage = vtkSmartPointer<vtkImageData>::New();
+    whiteImage->SetSpacing(spacing);
+    whiteImage->SetOrigin(origin);
+    whiteImage->SetExtent(extent);
+    whiteImage->AllocateScalars(VTK_UNSIGNED_CHAR,1);
+    unsigned char otval = 0;
+    unsigned char inval = 255;
+    unsigned char* white = static_cast<unsigned char*>(whiteImage->GetScalarPointer());
+    std::fill(white, white + whiteImage->GetNumberOfPoints(), inval);
+
+    vtkSmartPointer<vtkPolyDataToImageStencil> pol2stenc = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
+    pol2stenc->SetTolerance(0.5);
+    pol2stenc->SetInputConnection(extruder->GetOutputPort());
+    pol2stenc->SetOutputOrigin(origin);
+    pol2stenc->SetOutputSpacing(spacing);
+    pol2stenc->SetOutputWholeExtent(extent);
+    pol2stenc->Update();
+    vtkSmartPointer<vtkImageStencil> imgstenc = vtkSmartPointer<vtkImageStencil>::New();
+    imgstenc->SetInputData(whiteImage);
+    imgstenc->SetStencilConnection(pol2stenc->GetOutputPort());
+    imgstenc->ReverseStencilOff();
+    imgstenc->SetBackgroundValue(otval);
+    imgstenc->SetNumberOfThreads(1);
+    imgstenc->Update();
+
+    //VTK to ITK conversion, keeping the extent as the region index
+    ImageType::IndexType stencilStart;
+    ImageType::SizeType stencilSize;
+    for (int a=0; a<3; a++) {
+        stencilStart[a] = extent[2*a];
+        stencilSize[a] = extent[2*a+1] - extent[2*a] + 1;
+    }//_for
+    ImageType::Pointer stencilItkImage = ImageType::New();
+    stencilItkImage->SetRegions(ImageType::RegionType(stencilStart, stencilSize));
+    stencilItkImage->SetOrigin(origin);
+    stencilItkImage->SetSpacing(spacing);
+    stencilItkImage->Allocate();
+    unsigned char* stencil = static_cast<unsigned char*>(imgstenc->GetOutput()->GetScalarPointer());
+    std::copy(stencil, stencil + imgstenc->GetOutput()->GetNumberOfPoints(), stencilItkImage->GetBufferPointer());
+
+    //Same region on the segmentation lattice
+    ImageType::IndexType roiStart, roiEnd;
+    for (int a=0; a<3; a++) {
+        roiStart[a] = dimensions[a]-1;
+        roiEnd[a] = 0;
+    }//_for
+    for (int corner=0; corner<8; corner++) {
+        ImageType::PointType point;
+        for (int a=0; a<3; a++)
+            point[a] = origin[a] + spacing[a] * extent[2*a + ((corner >> a) & 1)];
+        itk::ContinuousIndex<double,3> index;
+        segItkImage->TransformPhysicalPointToContinuousIndex(point, index);
+        for (int a=0; a<3; a++) {
+            roiStart[a] = std::min(roiStart[a], (ImageType::IndexValueType)std::floor(index[a]) - 1);
+            roiEnd[a] = std::max(roiEnd[a], (ImageType::IndexValueType)std::ceil(index[a]) + 1);
+        }//_for
+    }//_for
+    ImageType::SizeType roiSize;
+    for (int a=0; a<3; a++) {
+        roiStart[a] = std::max(roiStart[a], (ImageType::IndexValueType)0);
+        roiEnd[a] = std::min(roiEnd[a], (ImageType::IndexValueType)dimensions[a]-1);
+        if (roiStart[a] > roiEnd[a])
+            return NULL;
+        roiSize[a] = roiEnd[a] - roiStart[a] + 1;
+    }//_for
+
+    itk::ResampleImageFilter<ImageType, ImageType>::Pointer resampleFilter;
+    resampleFilter = itk::ResampleImageFilter<ImageType, ImageType >::New();
+    resampleFilter->SetInput(stencilItkImage);
+    resampleFilter->SetOutputOrigin(segItkImage->GetOrigin());
+    resampleFilter->SetOutputSpacing(segItkImage->GetSpacing());
+    resampleFilter->SetOutputDirection(segItkImage->GetDirection());
+    resampleFilter->SetOutputStartIndex(roiStart);
+    resampleFilter->SetSize(roiSize);
+    resampleFilter->SetInterpolator(itk::NearestNeighborInterpolateImageFunction<ImageType>::New());
+    resampleFilter->SetDefaultPixelValue(0);
+    resampleFilter->SetNumberOfThreads(1);
+    resampleFilter->UpdateLargestPossibleRegion();
+
+    //Image Dilation
+    BallType binaryBall;
+    binaryBall.SetRadius(radius);
+    binaryBall.CreateStructuringElement();
+    DilationFilterType::Pointer dilationFilter = DilationFilterType::New();
+    dilationFilter->SetInput(resampleFilter->GetOutput());
+    dilationFilter->SetKernel(binaryBall);
+    dilationFilter->SetNumberOfThreads(1);
+    dilationFilter->UpdateLargestPossibleRegion();
+
+    ImageType::Pointer cutItkImage = dilationFilter->GetOutput();
+    cutItkImage->DisconnectPipeline();
+    return cutItkImage;
 }
 
 vtkIdType CemrgAtriaClipper::CentreOfMass(mitk::Surface::Pointer surface) {
@@ -650,6 +986,24 @@ std::vector<vtkSmartPointer<vtkRegularPolygonSource>> CemrgAtriaClipper::GetCent
     return centreLinePolyPlanes;
 }
 
+vtkSmartPointer<vtkPolyData> CemrgAtriaClipper::GetCentreLineVeinPlanes(int ctrLineNo) {
+
+    //Every section and its arrays, only computed when asked for
+    if (centreLineVeinPlanes.at(ctrLineNo) == NULL) {
+        vtkSmartPointer<vtkvmtkPolyDataCenterlineSections> ctrLineSects = vtkSmartPointer<vtkvmtkPolyDataCenterlineSections>::New();
+        ctrLineSects->SetInputData(surface->GetVtkPolyData());
+        ctrLineSects->SetCenterlines(centreLines.at(ctrLineNo)->GetOutput());
+        ctrLineSects->SetCenterlineSectionAreaArrayName("CentrelineSectionAreaArrayName");
+        ctrLineSects->SetCenterlineSectionMinSizeArrayName("CenterlineSectionMinSizeArrayName");
+        ctrLineSects->SetCenterlineSectionMaxSizeArrayName("CenterlineSectionMaxSizeArrayName");
+        ctrLineSects->SetCenterlineSectionShapeArrayName("CenterlineSectionShapeArrayName");
+        ctrLineSects->SetCenterlineSectionClosedArrayName("CenterlineSectionClosedArrayName");
+        ctrLineSects->Update();
+        centreLineVeinPlanes.at(ctrLineNo) = ctrLineSects->GetOutput();
+    }//_if
+    return centreLineVeinPlanes.at(ctrLineNo);
+}
+
 std::vector<int> CemrgAtriaClipper::GetManualType() const {
 
     return manuals;
@@ -663,6 +1017,7 @@ std::vector<std::vector<double>> CemrgAtriaClipper::GetMClipperAngles() {
 void CemrgAtriaClipper::SetToAutomaticClipperMode(int clippersIndex) {
 
     manuals[clippersIndex] = 0;
+    SetCutterModified(clippersIndex);
 }
 
 void CemrgAtriaClipper::SetMClipperAngles(double* value, int clippersIndex) {
@@ -670,15 +1025,26 @@ void CemrgAtriaClipper::SetMClipperAngles(double* value, int clippersIndex) {
     manuals[clippersIndex] = 1;
     normalPlAngles[clippersIndex][0] = value[0];
     normalPlAngles[clippersIndex][1] = value[1];
+    SetCutterModified(clippersIndex);
 }
 
 void CemrgAtriaClipper::SetMClipperSeeds(vtkSmartPointer<vtkPolyData> pickedCutterSeeds, int clippersIndex) {
 
     manuals[clippersIndex] = 2;
     centreLinePointPlanes.at(clippersIndex) = pickedCutterSeeds->GetPoints();
+    SetCutterModified(clippersIndex);
 }
 
 void CemrgAtriaClipper::SetRadiusAdjustment(double value) {
 
     radiusAdj = value;
 }
+
+void CemrgAtriaClipper::SetCutterModified(int clippersIndex) {
+
+    if (clippersIndex >= (int)cutterDirty.size()) {
+        cutterMasks.resize(clippersIndex+1);
+        cutterDirty.resize(clippersIndex+1, true);
+    }//_if
+    cutterDirty[clippersIndex] = true;
+}
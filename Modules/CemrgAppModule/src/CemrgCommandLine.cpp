@@ -30,6 +30,9 @@ PURPOSE.  See the above copyright notices for more information.
 #include <mitkIOUtil.h>
 #include <mitkProgressBar.h>
 
+// VTK
+#include <vtkPolyDataReader.h>
+
 // Qt
 #include <QFileDialog>
 #include <QFileInfo>
@@ -41,9 +44,16 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include <thread>
 #include <chrono>
+#include <cstdlib>
 #include <sys/stat.h>
 #include "CemrgCommandLine.h"
+#include "CemrgJobScheduler.h"
+#include "CemrgTrace.h"
+#include "CemrgFFDTransform.h"
+
 
+//Legacy ASCII meshes for tools that cannot read binary VTK
+bool CemrgCommandLine::vtkAsciiOutput = std::getenv("CEMRG_VTK_ASCII") != NULL;
 
 CemrgCommandLine::CemrgCommandLine() {
     isUI = true;
@@ -112,6 +122,7 @@ CemrgCommandLine::~CemrgCommandLine() {
  ***************************************************************************/
 
 QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, float th, int blur, int smth) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteSurf", dir);
 
   QString retOutput;
   QString dockerOutput = dockerSurf(dir, segPath, iter, th, blur, smth);
@@ -128,6 +139,9 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
 
     QDir apathd(aPath);
     if (apathd.exists()){
+      CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
+      QString threads = QString::number(cpus.GetThreads());
+
       //Dilation
       QStringList arguments;
       QString input  = segPath;
@@ -136,6 +150,7 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
       arguments << input;
       arguments << output;
       arguments << "-iterations" << QString::number(iter);
+      arguments << "-threads" << threads;
       arguments << "-verbose" << "3";
       completion = false;
       process->start(mirtk, arguments);
@@ -153,6 +168,7 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
       arguments << input;
       arguments << output;
       arguments << "-iterations" << QString::number(iter);
+      arguments << "-threads" << threads;
       arguments << "-verbose" << "3";
       completion = false;
       process->start(mirtk, arguments);
@@ -171,7 +187,9 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
       arguments << output;
       arguments << "-isovalue" << QString::number(th);
       arguments << "-blur" << QString::number(blur);
-      arguments << "-ascii";
+      if (vtkAsciiOutput)
+        arguments << "-ascii";
+      arguments << "-threads" << threads;
       arguments << "-verbose" << "3";
       completion = false;
       process->start(mirtk, arguments);
@@ -189,6 +207,7 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
       arguments << input;
       arguments << output;
       arguments << "-iterations" << QString::number(smth);
+      arguments << "-threads" << threads;
       arguments << "-verbose" << "3";
       completion = false;
       process->start(mirtk, arguments);
@@ -217,6 +236,7 @@ QString CemrgCommandLine::ExecuteSurf(QString dir, QString segPath, int iter, fl
 }
 
 QString CemrgCommandLine::ExecuteCreateCGALMesh(QString dir, QString fileName, QString templatePath) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteCreateCGALMesh", dir);
 
   QString dockerOutput = dockerCreateCGALMesh(dir, fileName, templatePath);
   QString retOutput;
@@ -234,6 +254,7 @@ QString CemrgCommandLine::ExecuteCreateCGALMesh(QString dir, QString fileName, Q
     QDir apathd(aPath);
     if(apathd.exists()){
       process->setWorkingDirectory(aPath);
+      CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
 
       //Setup EnVariable - in windows TBB_NUM_THREADS should be set in the system environment variables
       #ifndef _WIN32
@@ -241,7 +262,7 @@ QString CemrgCommandLine::ExecuteCreateCGALMesh(QString dir, QString fileName, Q
       //	process->start(setenv);
       //#else
       QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-      env.insert("TBB_NUM_THREADS","12");
+      env.insert("TBB_NUM_THREADS", QString::number(cpus.GetThreads()));
       process->setProcessEnvironment(env);
       #endif
 
@@ -287,6 +308,7 @@ QString CemrgCommandLine::ExecuteCreateCGALMesh(QString dir, QString fileName, Q
  ***************************************************************************/
 
 void CemrgCommandLine::ExecuteTracking(QString dir, QString imgTimes, QString param) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteTracking", dir);
 
   bool successful = dockerTracking(dir, imgTimes, param);
 
@@ -311,8 +333,9 @@ void CemrgCommandLine::ExecuteTracking(QString dir, QString imgTimes, QString pa
 
       arguments << "-images" << imgTimes;
       if (!param.isEmpty()) arguments << "-parin" << param;
+      CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
       arguments << "-dofout" << output;
-      arguments << "-threads" << "12";
+      arguments << "-threads" << QString::number(cpus.GetThreads());
       arguments << "-verbose" << "3";
 
       completion = false;
@@ -333,6 +356,32 @@ void CemrgCommandLine::ExecuteTracking(QString dir, QString imgTimes, QString pa
 }
 
 void CemrgCommandLine::ExecuteApplying(QString dir, QString inputMesh, double iniTime, QString dofin, int noFrames, int smooth) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteApplying", dir);
+
+  //Evaluate 4D FFDs in-process, MIRTK remains for the models it cannot handle
+  CemrgFFDTransform ffd;
+  if (ffd.Read(dofin)) {
+    vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+    reader->SetFileName(inputMesh.toStdString().c_str());
+    reader->Update();
+    if (reader->GetOutput()->GetPoints() != NULL) {
+      int fctTime = 10;
+      if (smooth == 2)
+      fctTime = 5;
+      else if (smooth == 5)
+      fctTime = 2;
+      std::vector<double> times;
+      for (int i=0; i<noFrames*smooth; i++)
+        times.push_back(iniTime + i*fctTime);
+      if (ffd.WriteTransformedMeshes(dir, reader->GetOutput(), times, vtkAsciiOutput)) {
+        mitk::ProgressBar::GetInstance()->Progress(noFrames*smooth);
+        return;
+      }//_if
+    }//_if
+    MITK_WARN << "Native transformation of the input mesh failed (type " << ffd.GetType() << "). Trying with MIRTK.";
+  } else
+    MITK_INFO << "Transformation not handled natively. Applying it with MIRTK.";
+
   bool successful = dockerApplying(dir, inputMesh, iniTime, dofin, noFrames, smooth);
   if(!successful){
     MITK_WARN << "Docker did not produce a good outcome. Trying with local MIRTK libraries.";
@@ -346,9 +395,8 @@ void CemrgCommandLine::ExecuteApplying(QString dir, QString inputMesh, double in
 
     QDir apathd(aPath);
     if(apathd.exists()){
-      process->setWorkingDirectory(aPath);
       //Setup
-      QStringList arguments;
+      QList<QStringList> argumentsList;
       QString input  = inputMesh;
       QString output = dir + mitk::IOUtil::GetDirectorySeparator() + "transformed-";
       QString mirtk  = aPath + mitk::IOUtil::GetDirectorySeparator() + "transform-points";
@@ -359,26 +407,23 @@ void CemrgCommandLine::ExecuteApplying(QString dir, QString inputMesh, double in
       else if (smooth == 5)
       fctTime = 2;
 
+      //Frames are independent, run them side by side within the CPU budget
       for (int i=0; i<noFrames; i++) {
 
-        arguments.clear();
+        QStringList arguments;
         arguments << input;
         arguments << output + QString::number(i) + ".vtk";
         arguments << "-dofin" << dofin;
-        arguments << "-ascii";
+        if (vtkAsciiOutput)
+          arguments << "-ascii";
         arguments << "-St";
         arguments << QString::number(iniTime);
+        arguments << "-threads" << "1";
         arguments << "-verbose" << "3";
-
-        completion = false;
-        process->start(mirtk, arguments);
-        while (!completion) {
-          std::this_thread::sleep_for(std::chrono::seconds(1));
-          QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-        }
+        argumentsList << arguments;
         iniTime += fctTime;
-        mitk::ProgressBar::GetInstance()->Progress();
       }
+      ExecuteConcurrently(mirtk, argumentsList, aPath);
     } else{
       QMessageBox::warning(NULL, "Please check the LOG", "MIRTK libraries not found");
       MITK_WARN << "MIRTK libraries not found. Please make sure the MLib folder is inside the directory;\n\t"+
@@ -388,6 +433,7 @@ void CemrgCommandLine::ExecuteApplying(QString dir, QString inputMesh, double in
 }
 
 void CemrgCommandLine::ExecuteRegistration(QString dir, QString lge, QString mra) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteRegistration", dir);
 
     //Setup registration
     QString input1 = dir + mitk::IOUtil::GetDirectorySeparator() + mra + ".nii";
@@ -413,8 +459,10 @@ void CemrgCommandLine::ExecuteRegistration(QString dir, QString lge, QString mra
 
         arguments << input1;
         arguments << input2;
+        CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
         arguments << "-dofout" << output;
         arguments << "-model" << "Rigid";
+        arguments << "-threads" << QString::number(cpus.GetThreads());
         arguments << "-verbose" << "3";
 
         completion = false;
@@ -435,6 +483,7 @@ void CemrgCommandLine::ExecuteRegistration(QString dir, QString lge, QString mra
 
 void CemrgCommandLine::ExecuteRegistration(QString dir, QString fixedfullpath,
   QString movingfullpath, QString txname, QString modelname) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteRegistration", dir);
 
     bool successful = dockerRegistration(dir, fixedfullpath, movingfullpath, txname, modelname);
 
@@ -460,8 +509,10 @@ void CemrgCommandLine::ExecuteRegistration(QString dir, QString fixedfullpath,
 
         arguments << input1;
         arguments << input2;
+        CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
         arguments << "-dofout" << output;
         arguments << "-model" << modelname;
+        arguments << "-threads" << QString::number(cpus.GetThreads());
         arguments << "-verbose" << "3";
 
         completion = false;
@@ -483,6 +534,7 @@ void CemrgCommandLine::ExecuteRegistration(QString dir, QString fixedfullpath,
 }
 
 void CemrgCommandLine::ExecuteTransformation(QString dir, QString imgName, QString regImgName) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteTransformation", dir);
 
   QString input  = imgName;
   QString output = regImgName;
@@ -531,6 +583,7 @@ void CemrgCommandLine::ExecuteTransformation(QString dir, QString imgName, QStri
 
 void CemrgCommandLine::ExecuteTransformation(QString dir, QString imgNamefullpath,
   QString regImgNamefullpath, QString txfullpath) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteTransformation", dir);
 
     bool successful = dockerTranformation(dir, imgNamefullpath, regImgNamefullpath, txfullpath);
 
@@ -576,6 +629,7 @@ void CemrgCommandLine::ExecuteTransformation(QString dir, QString imgNamefullpat
 
 void CemrgCommandLine::ExecuteResamplingOmNifti(QString niifullpath,
   QString outputtniifullpath, int isovalue) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteResamplingOmNifti", QFileInfo(niifullpath).absolutePath());
 // /resample-image niifullpath outputtniifullpath -isotropic 0.5 -interp CSpline -verbose 3
   bool successful = dockerResamplingOmNifti(niifullpath, outputtniifullpath, isovalue);
 
@@ -622,6 +676,7 @@ void CemrgCommandLine::ExecuteResamplingOmNifti(QString niifullpath,
 
 void CemrgCommandLine::ExecuteTransformationOnPoints(QString dir, QString meshfullpath,
   QString outputtmeshfullpath, QString txfullpath) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::ExecuteTransformationOnPoints", dir);
 
     bool successful = dockerTransformationOnPoints(dir, meshfullpath,  outputtmeshfullpath, txfullpath);
 
@@ -647,7 +702,8 @@ void CemrgCommandLine::ExecuteTransformationOnPoints(QString dir, QString meshfu
         arguments << input;
         arguments << output;
         arguments << "-dofin" << txfullpath;
-        arguments << "-ascii";
+        if (vtkAsciiOutput)
+          arguments << "-ascii";
         arguments << "-verbose" << "3";
 
         completion = false;
@@ -741,6 +797,7 @@ bool CemrgCommandLine::ConnectToServer(QString userID, QString server) {
 }
 
 bool CemrgCommandLine::TransferTFServer(QString directory, QString fname, QString userID, QString server, bool download) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::TransferTFServer", directory);
 
     //Setup transfer command
     QStringList arguments;
@@ -798,6 +855,7 @@ bool CemrgCommandLine::TransferTFServer(QString directory, QString fname, QStrin
 }
 
 void CemrgCommandLine::GPUReconstruction(QString userID, QString server, QStringList imgsList, QString targetImg, double resolution, double delta, int package, QString out) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::GPUReconstruction", QFileInfo(out).absolutePath());
 
     //Setup remote commands
     QStringList arguments;
@@ -835,6 +893,7 @@ void CemrgCommandLine::GPUReconstruction(QString userID, QString server, QString
 
 // Docker
 bool CemrgCommandLine::dockerRegistration(QString directory, QString fixed, QString moving, QString txname, QString modelname){
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerRegistration", directory);
   MITK_INFO << "[ATTENTION] Attempting MIRTK REGISTRATION using Docker.";
   QString aPath = "";
   #if defined(__APPLE__)
@@ -897,6 +956,7 @@ bool CemrgCommandLine::dockerRegistration(QString directory, QString fixed, QStr
 }
 
 bool CemrgCommandLine::dockerTranformation(QString directory, QString imgNamefullpath, QString regImgNamefullpath, QString txfullpath){
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerTranformation", directory);
   MITK_INFO << "[ATTENTION] Attempting MIRTK IMAGE TRANSFORMATION using Docker.";
   QString aPath = "";
   #if defined(__APPLE__)
@@ -950,6 +1010,7 @@ bool CemrgCommandLine::dockerTranformation(QString directory, QString imgNameful
 }
 
 bool CemrgCommandLine::dockerTransformationOnPoints(QString directory, QString meshfullpath, QString outputtmeshfullpath, QString txfullpath){
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerTransformationOnPoints", directory);
   MITK_INFO << "[ATTENTION] Attempting MIRTK MESH TRANSFORMATION using Docker.";
   QString aPath = "";
   #if defined(__APPLE__)
@@ -981,7 +1042,8 @@ bool CemrgCommandLine::dockerTransformationOnPoints(QString directory, QString m
   arguments << outputRelativePath;
   arguments << "-dofin" << dofRelativePath;
   arguments << "-nocompress";
-  arguments << "-ascii";
+  if (vtkAsciiOutput)
+    arguments << "-ascii";
   arguments << "-verbose" << "3";
 
   completion = false;
@@ -1004,6 +1066,7 @@ bool CemrgCommandLine::dockerTransformationOnPoints(QString directory, QString m
 }
 
 QString CemrgCommandLine::dockerExpandSurf(QString dir, QString segPath, int iter, float th, int blur, int smth){
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerExpandSurf", dir);
   MITK_INFO << "[ATTENTION] Attempting SURFACE CREATION using Docker.";
   QString aPath = "";
   #if defined(__APPLE__)
@@ -1058,7 +1121,8 @@ QString CemrgCommandLine::dockerExpandSurf(QString dir, QString segPath, int ite
   arguments << outputRelativePath;
   arguments << "-isovalue" << QString::number(th);
   arguments << "-blur" << QString::number(blur);
-  arguments << "-ascii";
+  if (vtkAsciiOutput)
+    arguments << "-ascii";
   arguments << "-verbose" << "3";
   completion = false;
   process->start(docker, arguments);
@@ -1102,6 +1166,7 @@ QString CemrgCommandLine::dockerExpandSurf(QString dir, QString segPath, int ite
   return outAbsolutepath;
 }
 QString CemrgCommandLine::dockerSurf(QString dir, QString segPath, int iter, float th, int blur, int smth){
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerSurf", dir);
   MITK_INFO << "[ATTENTION] Attempting SURFACE CREATION using Docker.";
   QString aPath = "";
   #if defined(__APPLE__)
@@ -1156,7 +1221,8 @@ QString CemrgCommandLine::dockerSurf(QString dir, QString segPath, int iter, flo
   arguments << outputRelativePath;
   arguments << "-isovalue" << QString::number(th);
   arguments << "-blur" << QString::number(blur);
-  arguments << "-ascii";
+  if (vtkAsciiOutput)
+    arguments << "-ascii";
   arguments << "-verbose" << "3";
   completion = false;
   process->start(docker, arguments);
@@ -1200,6 +1266,7 @@ QString CemrgCommandLine::dockerSurf(QString dir, QString segPath, int iter, flo
 }
 
 bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outputtniifullpath, int isovalue) {
+  CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerResamplingOmNifti", QFileInfo(niifullpath).absolutePath());
   // /resample-image niifullpath outputtniifullpath -isotropic 0.5 -interp CSpline -verbose 3
   MITK_INFO << "[ATTENTION] Attempting RESAMPLING IMAGE using Docker.";
   QString aPath = "";
@@ -1251,6 +1318,7 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
 
   // Tracking Utilities - Docker
   bool CemrgCommandLine::dockerTracking(QString dir, QString imgTimes, QString param) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerTracking", dir);
     MITK_INFO << "[ATTENTION] Attempting TRACKING (registration) using Docker";
     QString aPath = "";
     #if defined(__APPLE__)
@@ -1305,6 +1373,7 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
 }
 
   bool CemrgCommandLine::dockerApplying(QString dir, QString inputMesh, double iniTime, QString dofin, int noFrames, int smooth) {
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerApplying", dir);
     MITK_INFO << "[ATTENTION] Attempting APPLYING (registration) using Docker";
     QString aPath = "";
     #if defined(__APPLE__)
@@ -1316,18 +1385,11 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
     QString outputRelativePath_ = mirtkhome.relativeFilePath("transformed-");
     QString dofRelativePath = mirtkhome.relativeFilePath(dofin);
 
-    process->setWorkingDirectory(mirtkhome.absolutePath());
-
     // Setup docker
     QString docker = aPath+"docker";
     QString dockerimage = "biomedia/mirtk:v1.1.0";
     QString dockerexe  = "transform-points";
-    QStringList arguments;
-
-    arguments << "run";
-    arguments << "--volume="+mirtkhome.absolutePath()+":/data";
-    arguments << dockerimage;
-    arguments << dockerexe;
+    QList<QStringList> argumentsList;
 
       int fctTime = 10;
       noFrames *= smooth;
@@ -1341,38 +1403,37 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
           mitk::IOUtil::GetDirectorySeparator() + outputRelativePath_;
       for (int i=0; i<noFrames; i++) {
 
-          arguments.clear();
+          QStringList arguments;
           arguments << "run";
           arguments << "--volume="+mirtkhome.absolutePath()+":/data";
+          arguments << "--cpus=1";
           arguments << dockerimage;
           arguments << dockerexe;
 
           arguments << inputRelativePath;
           arguments << outputRelativePath_ + QString::number(i) + ".vtk";
           arguments << "-dofin" << dofRelativePath;
-          arguments << "-ascii";
+          if (vtkAsciiOutput)
+            arguments << "-ascii";
           arguments << "-St";
           arguments << QString::number(iniTime);
+          arguments << "-threads" << "1";
           arguments << "-verbose" << "3";
-
-          completion = false;
-          process->start(docker, arguments);
-          checkForStartedProcess();
-          while (!completion) {
-              std::this_thread::sleep_for(std::chrono::seconds(1));
-              QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-          }
-
-          suxs += (isOutputSuccessful(outAbsolutepath + QString::number(i) + ".vtk")) ? 1 : 0;
+          argumentsList << arguments;
           iniTime += fctTime;
-          mitk::ProgressBar::GetInstance()->Progress();
     }
 
+    //Each container transforms one frame, keep as many running as the budget allows
+    ExecuteConcurrently(docker, argumentsList, mirtkhome.absolutePath());
+    for (int i=0; i<noFrames; i++)
+        suxs += (isOutputSuccessful(outAbsolutepath + QString::number(i) + ".vtk")) ? 1 : 0;
+
     bool successful = (suxs == noFrames);
     return successful;
   }
 
   bool CemrgCommandLine::dockerSimpleTranslation(QString dir, QString sourceMeshP, QString targetMeshP, QString outputPath){
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerSimpleTranslation", dir);
     MITK_INFO << "[ATTENTION] Attempting INIT-DOF + TRANSFORM-POINTS using Docker.";
     QString aPath = "";
     #if defined(__APPLE__)
@@ -1430,7 +1491,8 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
     arguments << sourceRelativePath;
     arguments << outputRelativePath;
     arguments << "-dofin" << txRelativePath;
-    arguments << "-ascii";
+    if (vtkAsciiOutput)
+      arguments << "-ascii";
     arguments << "-verbose" << "3";
 
     MITK_INFO << printFullCommand(docker, arguments);
@@ -1456,6 +1518,7 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
   }
   // Docker - meshtools3d
   QString CemrgCommandLine::dockerCreateCGALMesh(QString dir, QString fileName, QString templatePath){
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerCreateCGALMesh", dir);
     MITK_INFO << "[ATTENTION] Attempting CreateCGALMesh (Meshtools3D) using Docker.";
     QString aPath = "";
     #if defined(__APPLE__)
@@ -1510,6 +1573,7 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
 
   //Docker - ML
   QString CemrgCommandLine::dockerCemrgNetPrediction(QString mra){
+    CEMRG_TRACE_SCOPE("CemrgCommandLine::dockerCemrgNetPrediction", QFileInfo(mra).absolutePath());
     MITK_INFO << "[CEMRGNET] Attempting prediction using Docker";
     QString aPath = "";
     #if defined(__APPLE__)
@@ -1599,6 +1663,62 @@ bool CemrgCommandLine::dockerResamplingOmNifti(QString niifullpath, QString outp
     return res;
   }
 
+  bool CemrgCommandLine::ExecuteConcurrently(QString program, QList<QStringList> argumentsList, QString workingDirectory){
+
+    int noJobs = argumentsList.size();
+    if (noJobs == 0)
+      return true;
+
+    //One thread per process, never more processes than reserved threads
+    CemrgJobScheduler::Reservation cpus(noJobs);
+    int slots = cpus.GetThreads();
+    MITK_INFO << ("Running " + QString::number(noJobs) + " processes, " + QString::number(slots) + " at a time.").toStdString();
+
+    int next = 0;
+    int failed = 0;
+    std::vector<QProcess*> running;
+    while (next < noJobs || !running.empty()) {
+
+      //Fill the free slots
+      while (next < noJobs && (int)running.size() < slots) {
+        QProcess* job = new QProcess();
+        job->setWorkingDirectory(workingDirectory);
+        job->setProcessChannelMode(QProcess::MergedChannels);
+        job->start(program, argumentsList.at(next));
+        if (job->waitForStarted()) {
+          running.push_back(job);
+        } else {
+          MITK_WARN << "[ATTENTION] Process error!";
+          MITK_INFO << printFullCommand(program, argumentsList.at(next));
+          mitk::ProgressBar::GetInstance()->Progress();
+          failed++;
+          delete job;
+        }
+        next++;
+      }//_while
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+
+      //Collect finished processes
+      for (std::vector<QProcess*>::iterator it = running.begin(); it != running.end();) {
+        QProcess* job = *it;
+        if (job->state() == QProcess::NotRunning) {
+          if (isUI)
+            panel->append(QString(job->readAll()) + job->program() + " Completed!");
+          if (job->exitStatus() != QProcess::NormalExit || job->exitCode() != 0)
+            failed++;
+          mitk::ProgressBar::GetInstance()->Progress();
+          delete job;
+          it = running.erase(it);
+        } else
+          ++it;
+      }//_for
+    }//_while
+
+    return failed == 0;
+  }
+
   void CemrgCommandLine::ExecuteTouch(QString filepath){
     QStringList arguments;
     arguments << filepath;
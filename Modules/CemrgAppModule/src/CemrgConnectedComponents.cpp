@@ -0,0 +1,232 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Connected Components for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Std
+#include <mutex>
+#include <numeric>
+#include <algorithm>
+
+#include "CemrgConnectedComponents.h"
+#include "CemrgJobScheduler.h"
+
+
+namespace {
+
+//Roots are always the smallest run index of their set
+int FindRoot(std::vector<int>& parent, int i) {
+
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }//_while
+    return i;
+}
+
+void Unite(std::vector<int>& parent, int a, int b) {
+
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+//Face neighbours between two rows are runs with overlapping x ranges
+void UniteRows(const std::vector<CemrgRunLengthImage::Run>& runs, std::vector<int>& parent,
+               int beginA, int endA, int beginB, int endB) {
+
+    int i = beginA, j = beginB;
+    while (i < endA && j < endB) {
+        long lastA = runs[i].x + (long)runs[i].length - 1;
+        long lastB = runs[j].x + (long)runs[j].length - 1;
+        if (runs[i].x <= lastB && runs[j].x <= lastA)
+            Unite(parent, i, j);
+        if (lastA < lastB)
+            i++;
+        else
+            j++;
+    }//_while
+}
+
+}//_namespace
+
+
+CemrgConnectedComponents::CemrgConnectedComponents() {
+}
+
+CemrgConnectedComponents::CemrgConnectedComponents(ImageType::Pointer image) {
+
+    Compute(image);
+}
+
+CemrgConnectedComponents::CemrgConnectedComponents(const CemrgRunLengthImage& mask) {
+
+    Compute(mask);
+}
+
+void CemrgConnectedComponents::Compute(ImageType::Pointer image) {
+
+    Compute(CemrgRunLengthImage(image));
+}
+
+void CemrgConnectedComponents::Compute(const CemrgRunLengthImage& mask) {
+
+    runImage = mask;
+    runComponents.clear();
+    components.clear();
+    const std::vector<CemrgRunLengthImage::Run>& runs = runImage.GetRuns();
+    int noRuns = runs.size();
+    if (noRuns == 0)
+        return;
+
+    //First run of every row, rows ordered by slice then y
+    ImageType::RegionType region = runImage.GetRegion();
+    ImageType::IndexType start = region.GetIndex();
+    int noRows = region.GetSize()[1];
+    int noSlices = region.GetSize()[2];
+    std::vector<int> rowStart(noRows * noSlices + 1, 0);
+    for (int i=0; i<noRuns; i++)
+        rowStart[(runs[i].z - start[2]) * noRows + (runs[i].y - start[1]) + 1]++;
+    std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+
+    //Slabs of slices are labelled concurrently, they only touch their own runs
+    std::vector<int> parent(noRuns);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<int> slabStarts;
+    std::mutex slabMutex;
+    CemrgJobScheduler::ParallelFor(noSlices, [&](int begin, int end) {
+        for (int z=begin; z<end; z++) {
+            for (int y=0; y<noRows; y++) {
+                int row = z * noRows + y;
+                for (int i=rowStart[row]+1; i<rowStart[row+1]; i++)
+                    if (runs[i-1].x + (long)runs[i-1].length == runs[i].x)
+                        Unite(parent, i-1, i);
+                if (y > 0)
+                    UniteRows(runs, parent, rowStart[row-1], rowStart[row], rowStart[row], rowStart[row+1]);
+                if (z > begin)
+                    UniteRows(runs, parent, rowStart[row-noRows], rowStart[row-noRows+1], rowStart[row], rowStart[row+1]);
+            }//_for
+        }//_for
+        std::lock_guard<std::mutex> lock(slabMutex);
+        slabStarts.push_back(begin);
+    }, 8);
+
+    //Slab borders
+    for (size_t s=0; s<slabStarts.size(); s++) {
+        int z = slabStarts[s];
+        if (z == 0)
+            continue;
+        for (int y=0; y<noRows; y++) {
+            int row = z * noRows + y;
+            UniteRows(runs, parent, rowStart[row-noRows], rowStart[row-noRows+1], rowStart[row], rowStart[row+1]);
+        }//_for
+    }//_for
+
+    //Roots appear in raster order of their first voxel, as ITK numbers components
+    std::vector<int> provisional(noRuns);
+    std::vector<Component> found;
+    std::vector<ImageType::IndexType> maxima;
+    for (int i=0; i<noRuns; i++) {
+        int root = FindRoot(parent, i);
+        const CemrgRunLengthImage::Run& run = runs[i];
+        ImageType::IndexType first, last;
+        first[0] = run.x; first[1] = run.y; first[2] = run.z;
+        last = first;
+        last[0] += run.length - 1;
+        if (root == i) {
+            provisional[i] = found.size();
+            Component component;
+            component.voxels = 0;
+            component.box.SetIndex(first);
+            found.push_back(component);
+            maxima.push_back(last);
+        } else
+            provisional[i] = provisional[root];
+
+        int c = provisional[i];
+        ImageType::IndexType min = found[c].box.GetIndex();
+        for (int k=0; k<3; k++) {
+            min[k] = std::min(min[k], first[k]);
+            maxima[c][k] = std::max(maxima[c][k], last[k]);
+        }//_for
+        found[c].box.SetIndex(min);
+        found[c].voxels += run.length;
+    }//_for
+
+    //Relabel by decreasing size, ties keep raster order
+    std::vector<int> order(found.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return found[a].voxels > found[b].voxels; });
+    std::vector<int> labelOf(found.size());
+    components.resize(found.size());
+    for (size_t l=0; l<order.size(); l++) {
+        int c = order[l];
+        ImageType::SizeType size;
+        for (int k=0; k<3; k++)
+            size[k] = maxima[c][k] - found[c].box.GetIndex()[k] + 1;
+        found[c].box.SetSize(size);
+        components[l] = found[c];
+        labelOf[c] = l + 1;
+    }//_for
+
+    runComponents.resize(noRuns);
+    for (int i=0; i<noRuns; i++)
+        runComponents[i] = labelOf[provisional[i]];
+}
+
+int CemrgConnectedComponents::GetNumberOfComponents() const {
+
+    return components.size();
+}
+
+const std::vector<CemrgConnectedComponents::Component>& CemrgConnectedComponents::GetComponents() const {
+
+    return components;
+}
+
+CemrgConnectedComponents::ImageType::Pointer CemrgConnectedComponents::GetLabelledImage(int noLargest) const {
+
+    std::vector<short> runLabels(runComponents.size());
+    for (size_t i=0; i<runComponents.size(); i++)
+        runLabels[i] = (noLargest <= 0 || runComponents[i] <= noLargest) ? runComponents[i] : 0;
+    return runImage.GetItkImage(runLabels);
+}
+
+CemrgConnectedComponents::ImageType::Pointer CemrgConnectedComponents::GetLabelledImage(const std::vector<int>& keepLabels) const {
+
+    std::vector<bool> keep(components.size() + 1, false);
+    for (size_t i=0; i<keepLabels.size(); i++)
+        if (keepLabels[i] > 0 && keepLabels[i] <= (int)components.size())
+            keep[keepLabels[i]] = true;
+
+    std::vector<short> runLabels(runComponents.size());
+    for (size_t i=0; i<runComponents.size(); i++)
+        runLabels[i] = keep[runComponents[i]] ? runComponents[i] : 0;
+    return runImage.GetItkImage(runLabels);
+}
@@ -0,0 +1,311 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * FFD Transformation for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkIOUtil.h>
+#include <mitkLogMacros.h>
+
+//VTK
+#include <vtkPolyDataWriter.h>
+
+//Qt
+#include <QFile>
+
+//Std
+#include <cmath>
+#include <cstring>
+#include "CemrgFFDTransform.h"
+#include "CemrgJobScheduler.h"
+
+namespace {
+
+    const unsigned int TRANSFORMATION_MAGIC = 815007;
+
+    //Type IDs of 4D B-spline FFDs whose lattice holds displacements. The
+    //velocity based models (TD, SV) store the same lattice but have to be
+    //integrated over time, they and any other type are left to MIRTK
+    const unsigned int TRANSFORMATION_BSPLINE_FFD_4D_v1 = 14;
+    const unsigned int DISPLACEMENT_FFD_TYPES[] = {TRANSFORMATION_BSPLINE_FFD_4D_v1};
+
+    bool IsDisplacementType(unsigned int type) {
+        for (unsigned int id : DISPLACEMENT_FFD_TYPES)
+            if (type == id)
+                return true;
+        return false;
+    }
+
+    unsigned int ReadUInt(const char* data, bool bigEndian) {
+        unsigned char b[4];
+        std::memcpy(b, data, 4);
+        if (bigEndian)
+            return (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+        return (b[3] << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
+    }
+
+    double ReadDouble(const char* data, bool bigEndian) {
+        unsigned char b[8];
+        std::memcpy(b, data, 8);
+        unsigned long long bits = 0;
+        for (int i=0; i<8; i++)
+            bits = (bits << 8) | b[bigEndian ? i : 7-i];
+        double value;
+        std::memcpy(&value, &bits, 8);
+        return value;
+    }
+
+    //Cubic B-spline weights of the four control points around u
+    int BSplineWeights(double u, double* w) {
+        double f = u - std::floor(u);
+        w[0] = (1-f)*(1-f)*(1-f)/6.0;
+        w[1] = (3*f*f*f - 6*f*f + 4)/6.0;
+        w[2] = (-3*f*f*f + 3*f*f + 3*f + 1)/6.0;
+        w[3] = f*f*f/6.0;
+        return (int)std::floor(u) - 1;
+    }
+}
+
+CemrgFFDTransform::CemrgFFDTransform() {
+
+    this->valid = false;
+    this->type = 0;
+    this->nx = 0, this->ny = 0, this->nz = 0, this->nt = 0;
+}
+
+bool CemrgFFDTransform::Read(QString dofPath) {
+
+    valid = false;
+    type = 0;
+    QFile file(dofPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray bytes = file.readAll();
+    file.close();
+    std::vector<char> buffer(bytes.constData(), bytes.constData() + bytes.size());
+
+    //Files are big endian, accept little endian writers as well
+    if (buffer.size() < 8)
+        return false;
+    if (ReadUInt(&buffer[0], true) == TRANSFORMATION_MAGIC)
+        valid = ParseLayout(buffer, true);
+    else if (ReadUInt(&buffer[0], false) == TRANSFORMATION_MAGIC)
+        valid = ParseLayout(buffer, false);
+
+    if (!valid)
+        MITK_INFO << ("Transformation not handled natively, type " + QString::number(type) + ": " + dofPath).toStdString();
+    return valid;
+}
+
+bool CemrgFFDTransform::IsValid() const {
+
+    return valid;
+}
+
+unsigned int CemrgFFDTransform::GetType() const {
+
+    return type;
+}
+
+std::vector<vtkSmartPointer<vtkPoints>> CemrgFFDTransform::TransformPoints(vtkPoints* points, const std::vector<double>& times) const {
+
+    int noPoints = points->GetNumberOfPoints();
+    int noTimes = times.size();
+    std::vector<vtkSmartPointer<vtkPoints>> outputs(noTimes);
+    for (int f=0; f<noTimes; f++) {
+        outputs[f] = vtkSmartPointer<vtkPoints>::New();
+        outputs[f]->SetDataTypeToFloat();
+        outputs[f]->SetNumberOfPoints(noPoints);
+    }//_for
+
+    //Spatial weights are shared by all time points of a point
+    CemrgJobScheduler::ParallelFor(noPoints, [&](int begin, int end) {
+        std::vector<double> moved(3 * noTimes);
+        for (int i=begin; i<end; i++) {
+            double point[3];
+            points->GetPoint(i, point);
+            Displacements(point, times, moved.data());
+            for (int f=0; f<noTimes; f++)
+                outputs[f]->SetPoint(i, moved.data() + 3*f);
+        }//_for
+    }, 256);
+
+    return outputs;
+}
+
+bool CemrgFFDTransform::WriteTransformedMeshes(QString dir, vtkPolyData* input, const std::vector<double>& times, bool ascii) const {
+
+    std::vector<vtkSmartPointer<vtkPoints>> outputs = TransformPoints(input->GetPoints(), times);
+    for (size_t f=0; f<outputs.size(); f++) {
+
+        vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+        pd->ShallowCopy(input);
+        pd->SetPoints(outputs[f]);
+
+        QString path = dir + mitk::IOUtil::GetDirectorySeparator() + "transformed-" + QString::number(f) + ".vtk";
+        vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+        writer->SetFileName(path.toStdString().c_str());
+        writer->SetInputData(pd);
+        if (ascii)
+            writer->SetFileTypeToASCII();
+        else
+            writer->SetFileTypeToBinary();
+        if (writer->Write() == 0)
+            return false;
+    }//_for
+
+    return true;
+}
+
+/********************************************
+ *        Private Members Defintions        *
+ ********************************************/
+
+void CemrgFFDTransform::Displacements(const double* point, const std::vector<double>& times, double* output) const {
+
+    //World to lattice, the origin is the centre of the lattice
+    double d[3] = {point[0]-origin[0], point[1]-origin[1], point[2]-origin[2]};
+    double u[3];
+    int dims[3] = {nx, ny, nz};
+    for (int a=0; a<3; a++)
+        u[a] = (axes[a][0]*d[0] + axes[a][1]*d[1] + axes[a][2]*d[2]) / spacing[a] + (dims[a]-1) / 2.0;
+
+    double wx[4], wy[4], wz[4];
+    int i0 = BSplineWeights(u[0], wx);
+    int j0 = BSplineWeights(u[1], wy);
+    int k0 = BSplineWeights(u[2], wz);
+
+    //Spatial sums per temporal control point, outside the lattice is zero
+    std::vector<double> sums(3 * nt, 0.0);
+    for (int l=0; l<nt; l++) {
+        double* s = &sums[3*l];
+        for (int c=0; c<4; c++) {
+            int k = k0 + c;
+            if (k < 0 || k >= nz) continue;
+            for (int b=0; b<4; b++) {
+                int j = j0 + b;
+                if (j < 0 || j >= ny) continue;
+                double wyz = wy[b] * wz[c];
+                const double* row = &coefficients[3 * (((size_t)l*nz + k)*ny + j)*nx];
+                for (int a=0; a<4; a++) {
+                    int i = i0 + a;
+                    if (i < 0 || i >= nx) continue;
+                    double w = wx[a] * wyz;
+                    s[0] += w * row[3*i+0];
+                    s[1] += w * row[3*i+1];
+                    s[2] += w * row[3*i+2];
+                }//_for
+            }//_for
+        }//_for
+    }//_for
+
+    for (size_t f=0; f<times.size(); f++) {
+        double wt[4];
+        int l0 = BSplineWeights((times[f] - origin[3]) / spacing[3], wt);
+        double disp[3] = {0, 0, 0};
+        for (int m=0; m<4; m++) {
+            int l = l0 + m;
+            if (l < 0 || l >= nt) continue;
+            disp[0] += wt[m] * sums[3*l+0];
+            disp[1] += wt[m] * sums[3*l+1];
+            disp[2] += wt[m] * sums[3*l+2];
+        }//_for
+        output[3*f+0] = point[0] + disp[0];
+        output[3*f+1] = point[1] + disp[1];
+        output[3*f+2] = point[2] + disp[2];
+    }//_for
+}
+
+bool CemrgFFDTransform::ParseLayout(const std::vector<char>& buffer, bool bigEndian) {
+
+    const char* data = buffer.data();
+    size_t size = buffer.size();
+    if (size < 24)
+        return false;
+    type = ReadUInt(data + 4, bigEndian);
+    if (!IsDisplacementType(type))
+        return false;
+
+    nx = ReadUInt(data + 8, bigEndian);
+    ny = ReadUInt(data + 12, bigEndian);
+    nz = ReadUInt(data + 16, bigEndian);
+    nt = ReadUInt(data + 20, bigEndian);
+    if (nx < 1 || ny < 1 || nz < 1 || nt < 1 || nx > 4096 || ny > 4096 || nz > 4096 || nt > 4096)
+        return false;
+    size_t noCPs = (size_t)nx * ny * nz * nt;
+
+    //Older writers omit the z axis, the extrapolation mode and the status,
+    //exactly one combination has to explain the file size
+    int matches = 0;
+    bool zAxis = false, extrapolation = false;
+    for (int variant=0; variant<8; variant++) {
+        bool hasZ = variant & 1, hasExt = variant & 2, hasStatus = variant & 4;
+        size_t expected = 24 + 8*(hasZ ? 9 : 6) + 8*4 + 8*4 + (hasExt ? 4 : 0) + 24*noCPs + (hasStatus ? 12*noCPs : 0);
+        if (expected == size) {
+            matches++;
+            zAxis = hasZ, extrapolation = hasExt;
+        }//_if
+    }//_for
+    if (matches != 1)
+        return false;
+
+    const char* cursor = data + 24;
+    for (int a=0; a<(zAxis ? 3 : 2); a++)
+        for (int c=0; c<3; c++, cursor += 8)
+            axes[a][c] = ReadDouble(cursor, bigEndian);
+    if (!zAxis) {
+        axes[2][0] = axes[0][1]*axes[1][2] - axes[0][2]*axes[1][1];
+        axes[2][1] = axes[0][2]*axes[1][0] - axes[0][0]*axes[1][2];
+        axes[2][2] = axes[0][0]*axes[1][1] - axes[0][1]*axes[1][0];
+    }//_if
+    for (int a=0; a<4; a++, cursor += 8)
+        spacing[a] = ReadDouble(cursor, bigEndian);
+    for (int a=0; a<4; a++, cursor += 8)
+        origin[a] = ReadDouble(cursor, bigEndian);
+    if (extrapolation)
+        cursor += 4;
+
+    //Lattice has to be orthonormal with positive spacing
+    for (int a=0; a<3; a++) {
+        for (int b=0; b<3; b++) {
+            double dot = axes[a][0]*axes[b][0] + axes[a][1]*axes[b][1] + axes[a][2]*axes[b][2];
+            if (std::fabs(dot - (a == b ? 1.0 : 0.0)) > 1e-3)
+                return false;
+        }//_for
+    }//_for
+    for (int a=0; a<4; a++)
+        if (!(spacing[a] > 0) || !std::isfinite(origin[a]))
+            return false;
+
+    coefficients.resize(3 * noCPs);
+    for (size_t i=0; i<coefficients.size(); i++, cursor += 8) {
+        coefficients[i] = ReadDouble(cursor, bigEndian);
+        if (!std::isfinite(coefficients[i]))
+            return false;
+    }//_for
+
+    return true;
+}
@@ -27,20 +27,130 @@ PURPOSE.  See the above copyright notices for more information.
 =========================================================================*/
 
 //ITK
-#include <itkNearestNeighborInterpolateImageFunction.h>
-#include <itkResampleImageFilter.h>
+#include <itkRegionOfInterestImageFilter.h>
+#include <itkImageRegionIterator.h>
 
 //Qmitk
 #include <mitkBoundingObjectCutter.h>
 #include <mitkProgressBar.h>
 #include <mitkDataNode.h>
-#include <mitkImageCast.h>
+#include <mitkIOUtil.h>
+#include <mitkImageAccessByItk.h>
 #include <mitkITKImageImport.h>
 
 //Qt
 #include <QMessageBox>
 
+//Std
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <future>
+#include <algorithm>
+
 #include "CemrgImageUtils.h"
+#include "CemrgJobScheduler.h"
+
+
+namespace {
+
+//MITK image IO switches the process-wide locale on every read and write
+std::mutex imageIOMutex;
+
+template <typename TPixel, unsigned int VImageDimension>
+void CropItkImage(itk::Image<TPixel, VImageDimension>* itkImage, const itk::ImageRegion<3>& region,
+                  const std::vector<bool>& inside, bool fullyInside, mitk::Image::Pointer& output) {
+
+    typedef itk::Image<TPixel, VImageDimension> ImageType;
+    typedef itk::RegionOfInterestImageFilter<ImageType, ImageType> RoiFilterType;
+
+    //Copy of the box, origin moves to its first voxel
+    typename RoiFilterType::Pointer roi = RoiFilterType::New();
+    roi->SetInput(itkImage);
+    roi->SetRegionOfInterest(region);
+    roi->SetNumberOfThreads(1);
+    roi->Update();
+
+    //Voxels of the box outside a rotated cutter, as BoundingObjectCutter does
+    typename ImageType::Pointer cropped = roi->GetOutput();
+    if (!fullyInside) {
+        size_t i = 0;
+        itk::ImageRegionIterator<ImageType> it(cropped, cropped->GetLargestPossibleRegion());
+        for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++i)
+            if (!inside[i])
+                it.Set(0);
+    }//_if
+    output = mitk::ImportItkImage(cropped)->Clone();
+}
+
+
+template <typename TPixel, unsigned int VImageDimension>
+void DecimateItkImage(itk::Image<TPixel, VImageDimension>* itkImage, int factor, bool average, mitk::Image::Pointer& output) {
+
+    typedef itk::Image<TPixel, VImageDimension> ImageType;
+
+    //Integer factor grid, every factor-th voxel from the first one
+    typename ImageType::SizeType inSize = itkImage->GetBufferedRegion().GetSize();
+    typename ImageType::SizeType outSize;
+    for (int i=0; i<3; i++)
+        outSize[i] = std::max((itk::SizeValueType)1, inSize[i] / factor);
+
+    typename ImageType::SpacingType spacing = itkImage->GetSpacing();
+    spacing *= (double)factor;
+    typename ImageType::PointType origin = itkImage->GetOrigin();
+    if (average) {
+        //Block means sit at the centre of their block
+        typename ImageType::SpacingType shift = itkImage->GetSpacing();
+        shift *= 0.5 * (factor - 1);
+        origin += itkImage->GetDirection() * shift;
+    }//_if
+
+    typename ImageType::Pointer decimated = ImageType::New();
+    decimated->SetRegions(outSize);
+    decimated->SetSpacing(spacing);
+    decimated->SetOrigin(origin);
+    decimated->SetDirection(itkImage->GetDirection());
+    decimated->Allocate();
+
+    const TPixel* in = itkImage->GetBufferPointer();
+    TPixel* out = decimated->GetBufferPointer();
+    const size_t inRow = inSize[0];
+    const size_t inSlice = inSize[0] * inSize[1];
+    const size_t outRow = outSize[0];
+    const size_t outSlice = outSize[0] * outSize[1];
+    const int blockSize = (int)std::min(inSize[0], (itk::SizeValueType)factor)
+            * (int)std::min(inSize[1], (itk::SizeValueType)factor)
+            * (int)std::min(inSize[2], (itk::SizeValueType)factor);
+
+    //Output slices are independent
+    CemrgJobScheduler::ParallelFor(outSize[2], [&](int begin, int end) {
+        for (int z=begin; z<end; z++) {
+            for (size_t y=0; y<outSize[1]; y++) {
+                TPixel* dst = out + z * outSlice + y * outRow;
+                const TPixel* src = in + (size_t)z * factor * inSlice + y * factor * inRow;
+                if (!average) {
+                    for (size_t x=0; x<outSize[0]; x++)
+                        dst[x] = src[x * factor];
+                    continue;
+                }//_if
+                for (size_t x=0; x<outSize[0]; x++) {
+                    double sum = 0;
+                    for (int k=0; k<factor && (size_t)z*factor+k<inSize[2]; k++)
+                        for (int j=0; j<factor && y*factor+j<inSize[1]; j++)
+                            for (int i=0; i<factor && x*factor+i<inSize[0]; i++)
+                                sum += src[k * inSlice + j * inRow + x * factor + i];
+                    double mean = sum / blockSize;
+                    dst[x] = static_cast<TPixel>(std::numeric_limits<TPixel>::is_integer ? std::floor(mean + 0.5) : mean);
+                }//_for
+            }//_for
+        }//_for
+    }, 4);
+
+    //Buffer ownership moves to MITK, no extra copy
+    output = mitk::GrabItkImageMemory(decimated);
+}
+
+}//_namespace
 
 
 mitk::DataNode::Pointer CemrgImageUtils::imageNode;
@@ -48,36 +158,138 @@ mitk::DataNode::Pointer CemrgImageUtils::cuttingNode;
 mitk::Image::Pointer CemrgImageUtils::imageToCut;
 mitk::BoundingObject::Pointer CemrgImageUtils::cuttingCube;
 
+CemrgImageUtils::CemrgImageUtils(mitk::BoundingObject::Pointer cuttingCube, mitk::Image::Pointer referenceImage) {
+
+    valid = false;
+    fullyInside = true;
+    if (cuttingCube.IsNull() || referenceImage.IsNull() || referenceImage->GetDimension() < 3)
+        return;
+
+    //Bounds of the box in continuous index coordinates of the reference
+    mitk::BaseGeometry* geometry = referenceImage->GetGeometry();
+    mitk::BoundingBox::Pointer box = cuttingCube->GetGeometry()->CalculateBoundingBoxRelativeToTransform(geometry->GetIndexToWorldTransform());
+    mitk::BoundingBox::PointType min = box->GetMinimum();
+    mitk::BoundingBox::PointType max = box->GetMaximum();
+
+    itk::ImageRegion<3>::IndexType index;
+    itk::ImageRegion<3>::SizeType size;
+    itk::ImageRegion<3> largest;
+    for (int i=0; i<3; i++) {
+        index[i] = (itk::IndexValueType)std::ceil(min[i]);
+        size[i] = (itk::SizeValueType)std::max(0.0, std::ceil(max[i]) - index[i]);
+        largest.SetSize(i, referenceImage->GetDimension(i));
+    }//_for
+    cropRegion.SetIndex(index);
+    cropRegion.SetSize(size);
+    if (!cropRegion.Crop(largest) || cropRegion.GetNumberOfPixels() == 0)
+        return;
+
+    //Inside test once per voxel, shared by every crop of this box
+    index = cropRegion.GetIndex();
+    size = cropRegion.GetSize();
+    insideVoxels.resize(cropRegion.GetNumberOfPixels());
+    size_t i = 0;
+    for (itk::SizeValueType z=0; z<size[2]; z++) {
+        for (itk::SizeValueType y=0; y<size[1]; y++) {
+            for (itk::SizeValueType x=0; x<size[0]; x++, i++) {
+                mitk::Point3D voxel, world;
+                voxel[0] = index[0] + x;
+                voxel[1] = index[1] + y;
+                voxel[2] = index[2] + z;
+                geometry->IndexToWorld(voxel, world);
+                insideVoxels[i] = cuttingCube->IsInside(world);
+                fullyInside = fullyInside && insideVoxels[i];
+            }//_for
+        }//_for
+    }//_for
+    valid = true;
+}
+
+bool CemrgImageUtils::IsValid() const {
+
+    return valid;
+}
+
+mitk::Image::Pointer CemrgImageUtils::Crop(mitk::Image::Pointer image) const {
+
+    if (!valid || image.IsNull() || image->GetDimension() != 3)
+        return NULL;
+    for (int i=0; i<3; i++)
+        if (cropRegion.GetIndex()[i] + (itk::IndexValueType)cropRegion.GetSize()[i] > (itk::IndexValueType)image->GetDimension(i))
+            return NULL;
+
+    mitk::Image::Pointer resultImage;
+    try {
+        AccessFixedDimensionByItk_n(image, CropItkImage, 3, (cropRegion, insideVoxels, fullyInside, resultImage));
+    } catch (const itk::ExceptionObject& e) {
+        MITK_WARN << "The Cropping filter could not process because of: " << e.GetDescription();
+        return NULL;
+    }//try
+
+    resultImage->SetPropertyList(image->GetPropertyList()->Clone());
+    return resultImage;
+}
+
+int CemrgImageUtils::CropSeries(QString dir, int noFrames, int firstFrame, QString prefix) const {
+
+    //Each time point is cropped in place by its own job, only the crops overlap
+    std::vector<std::shared_future<void>> jobs;
+    std::vector<int> cropped(std::max(0, noFrames - firstFrame), 0);
+    for (int i=firstFrame; i<noFrames; i++) {
+        std::string path = (dir + mitk::IOUtil::GetDirectorySeparator() + prefix + QString::number(i) + ".nii").toStdString();
+        int* done = &cropped[i - firstFrame];
+        jobs.push_back(CemrgJobScheduler::GetInstance()->Submit([this, path, done](int) {
+            try {
+                mitk::Image::Pointer inputImage;
+                {
+                    std::lock_guard<std::mutex> lock(imageIOMutex);
+                    inputImage = mitk::IOUtil::Load<mitk::Image>(path);
+                }
+                mitk::Image::Pointer outputImage = Crop(inputImage);
+                if (outputImage.IsNotNull()) {
+                    std::lock_guard<std::mutex> lock(imageIOMutex);
+                    mitk::IOUtil::Save(outputImage, path);
+                    *done = 1;
+                }//_if
+            } catch (const std::exception& e) {
+                MITK_WARN << "Cropping of " << path << " skipped: " << e.what();
+            }//_try
+        }));
+    }//_for
+
+    //Progress is reported from the calling thread only
+    int noCropped = 0;
+    for (size_t i=0; i<jobs.size(); i++) {
+        jobs[i].get();
+        noCropped += cropped[i];
+        mitk::ProgressBar::GetInstance()->Progress(2);
+    }//_for
+    return noCropped;
+}
+
 mitk::Image::Pointer CemrgImageUtils::CropImage() {
 
     //Test input objects
     if (imageToCut.IsNull() || cuttingCube.IsNull())
         return NULL;
 
-    //Prepare the cutter
-    mitk::BoundingObjectCutter::Pointer cutter = mitk::BoundingObjectCutter::New();
-    cutter->SetBoundingObject(cuttingCube);
-    cutter->SetInput(imageToCut);
-    cutter->AutoOutsideValueOff();
+    //Time series keep the cutter filter, volumes use the shared box
+    if (imageToCut->GetDimension() != 3)
+        return CropWithCutter();
 
     //Actual cutting
-    try {
-        cutter->Update();
-        mitk::ProgressBar::GetInstance()->Progress();
-    } catch (const itk::ExceptionObject& e) {
-        std::string message = std::string("The Cropping filter could not process because of: \n ") + e.GetDescription();
+    CemrgImageUtils cropper(cuttingCube, imageToCut);
+    mitk::Image::Pointer resultImage = cropper.Crop(imageToCut);
+    mitk::ProgressBar::GetInstance()->Progress();
+    if (resultImage.IsNull()) {
         QMessageBox::warning(
-                    NULL, "Cropping not possible!", message.c_str(),
+                    NULL, "Cropping not possible!", "The cutter does not overlap the image to crop!",
                     QMessageBox::Ok, QMessageBox::NoButton, QMessageBox::NoButton);
         return NULL;
-    }//try
+    }//_if
 
     //Cutting successful
-    mitk::Image::Pointer resultImage = cutter->GetOutput();
-    resultImage->DisconnectPipeline();
-    resultImage->SetPropertyList(imageToCut->GetPropertyList()->Clone());
     mitk::ProgressBar::GetInstance()->Progress();
-
     return resultImage;
 }
 
@@ -111,40 +323,99 @@ mitk::DataNode::Pointer CemrgImageUtils::GetCuttingNode() {
     return cuttingNode;
 }
 
-mitk::Image::Pointer CemrgImageUtils::Downsample(mitk::Image::Pointer image, int factor) {
+mitk::Image::Pointer CemrgImageUtils::GetImageToCut() {
 
-    typedef itk::Image<short,3> ImageType;
-    typedef itk::ResampleImageFilter<ImageType, ImageType> ResampleImageFilterType;
-    typedef itk::NearestNeighborInterpolateImageFunction<ImageType, double> NearestInterpolatorType;
+    return imageToCut;
+}
 
-    //Cast to ITK
-    ImageType::Pointer itkImage = ImageType::New();
-    mitk::CastToItkImage(image, itkImage);
+mitk::BoundingObject::Pointer CemrgImageUtils::GetCuttingCube() {
 
-    ResampleImageFilterType::Pointer downsampler = ResampleImageFilterType::New();
-    downsampler->SetInput(itkImage);
+    return cuttingCube;
+}
 
-    NearestInterpolatorType::Pointer interpolator = NearestInterpolatorType::New();
-    downsampler->SetInterpolator(interpolator);
+mitk::Image::Pointer CemrgImageUtils::Downsample(mitk::Image::Pointer image, int factor, bool average) {
 
-    downsampler->SetDefaultPixelValue(0);
+    image = Decimate(image, factor, average);
+    mitk::ProgressBar::GetInstance()->Progress();
+    return image;
+}
 
-    ResampleImageFilterType::SpacingType spacing = itkImage->GetSpacing();
-    spacing *= (double) factor;
-    downsampler->SetOutputSpacing(spacing);
+int CemrgImageUtils::DownsampleSeries(QString dir, int noFrames, int factor, int firstFrame, QString prefix, bool average) {
+
+    //Each time point is decimated in place by its own job, IO as in CropSeries
+    std::vector<std::shared_future<void>> jobs;
+    std::vector<int> sampled(std::max(0, noFrames - firstFrame), 0);
+    for (int i=firstFrame; i<noFrames; i++) {
+        std::string path = (dir + mitk::IOUtil::GetDirectorySeparator() + prefix + QString::number(i) + ".nii").toStdString();
+        int* done = &sampled[i - firstFrame];
+        jobs.push_back(CemrgJobScheduler::GetInstance()->Submit([path, factor, average, done](int) {
+            try {
+                mitk::Image::Pointer inputImage;
+                {
+                    std::lock_guard<std::mutex> lock(imageIOMutex);
+                    inputImage = mitk::IOUtil::Load<mitk::Image>(path);
+                }
+                mitk::Image::Pointer outputImage = Decimate(inputImage, factor, average);
+                if (outputImage.IsNotNull()) {
+                    std::lock_guard<std::mutex> lock(imageIOMutex);
+                    mitk::IOUtil::Save(outputImage, path);
+                    *done = 1;
+                }//_if
+            } catch (const std::exception& e) {
+                MITK_WARN << "Downsampling of " << path << " skipped: " << e.what();
+            }//_try
+        }));
+    }//_for
+
+    //Progress is reported from the calling thread only
+    int noSampled = 0;
+    for (size_t i=0; i<jobs.size(); i++) {
+        jobs[i].get();
+        noSampled += sampled[i];
+        mitk::ProgressBar::GetInstance()->Progress();
+    }//_for
+    return noSampled;
+}
 
-    downsampler->SetOutputOrigin(itkImage->GetOrigin());
-    downsampler->SetOutputDirection(itkImage->GetDirection());
+/********************************************
+ *        Private Members Defintions        *
+ ********************************************/
 
-    ResampleImageFilterType::SizeType size = itkImage->GetLargestPossibleRegion().GetSize();
-    for (int i=0; i<3; ++i)
-        size[i] /= factor;
+mitk::Image::Pointer CemrgImageUtils::CropWithCutter() {
 
-    downsampler->SetSize(size);
-    downsampler->UpdateLargestPossibleRegion();
+    //Prepare the cutter
+    mitk::BoundingObjectCutter::Pointer cutter = mitk::BoundingObjectCutter::New();
+    cutter->SetBoundingObject(cuttingCube);
+    cutter->SetInput(imageToCut);
+    cutter->AutoOutsideValueOff();
 
-    //Save downsampled image
-    image = mitk::ImportItkImage(downsampler->GetOutput())->Clone();
+    //Actual cutting
+    try {
+        cutter->Update();
+        mitk::ProgressBar::GetInstance()->Progress();
+    } catch (const itk::ExceptionObject& e) {
+        std::string message = std::string("The Cropping filter could not process because of: \n ") + e.GetDescription();
+        QMessageBox::warning(
+                    NULL, "Cropping not possible!", message.c_str(),
+                    QMessageBox::Ok, QMessageBox::NoButton, QMessageBox::NoButton);
+        return NULL;
+    }//try
+
+    //Cutting successful
+    mitk::Image::Pointer resultImage = cutter->GetOutput();
+    resultImage->DisconnectPipeline();
+    resultImage->SetPropertyList(imageToCut->GetPropertyList()->Clone());
     mitk::ProgressBar::GetInstance()->Progress();
-    return image;
+
+    return resultImage;
+}
+
+mitk::Image::Pointer CemrgImageUtils::Decimate(mitk::Image::Pointer image, int factor, bool average) {
+
+    if (image.IsNull() || image->GetDimension() != 3 || factor < 1)
+        return NULL;
+
+    mitk::Image::Pointer resultImage;
+    AccessFixedDimensionByItk_n(image, DecimateItkImage, 3, (factor, average, resultImage));
+    return resultImage;
 }
@@ -0,0 +1,165 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Intensity Statistics for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Std
+#include <cmath>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+
+#include "CemrgIntensityStats.h"
+#include "CemrgJobScheduler.h"
+
+
+CemrgIntensityStats::CemrgIntensityStats() {
+
+    count = 0;
+    mean = 0;
+    stdDev = 0;
+    minValue = 0;
+    maxValue = 0;
+}
+
+CemrgIntensityStats::CemrgIntensityStats(ImageType::Pointer image, ImageType::Pointer mask, bool skipZeros) {
+
+    Compute(image, mask, skipZeros);
+}
+
+void CemrgIntensityStats::Compute(ImageType::Pointer image, ImageType::Pointer mask, bool skipZeros) {
+
+    count = 0;
+    mean = 0;
+    stdDev = 0;
+    minValue = 0;
+    maxValue = 0;
+    histogram.clear();
+    if (image.IsNull() || mask.IsNull() || image->GetBufferedRegion().GetSize() != mask->GetBufferedRegion().GetSize())
+        return;
+
+    //Per-thread histograms over the whole short range, merged once per thread
+    const int offset = -(int)std::numeric_limits<short>::min();
+    const int noBins = (int)std::numeric_limits<short>::max() + offset + 1;
+    const short* img = image->GetBufferPointer();
+    const short* msk = mask->GetBufferPointer();
+    std::vector<long long> bins(noBins, 0);
+    std::mutex mergeMutex;
+
+    CemrgJobScheduler::ParallelFor(image->GetBufferedRegion().GetNumberOfPixels(), [&](int begin, int end) {
+        std::vector<long long> local(noBins, 0);
+        for (int i=begin; i<end; i++)
+            if (msk[i] != 0 && (!skipZeros || img[i] != 0))
+                local[img[i] + offset]++;
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        for (int b=0; b<noBins; b++)
+            bins[b] += local[b];
+    }, 1<<16);
+
+    //Counts are exact, so the result does not depend on the thread split
+    int first = 0, last = noBins - 1;
+    while (first < noBins && bins[first] == 0)
+        first++;
+    if (first == noBins)
+        return;
+    while (bins[last] == 0)
+        last--;
+
+    double sum = 0;
+    for (int b=first; b<=last; b++) {
+        count += bins[b];
+        sum += (double)bins[b] * (b - offset);
+    }//_for
+    mean = sum / count;
+
+    double diff = 0;
+    for (int b=first; b<=last; b++)
+        diff += bins[b] * ((b - offset) - mean) * ((b - offset) - mean);
+    stdDev = std::sqrt(diff / count);
+
+    minValue = first - offset;
+    maxValue = last - offset;
+    histogram.assign(bins.begin() + first, bins.begin() + last + 1);
+}
+
+long long CemrgIntensityStats::GetCount() const {
+
+    return count;
+}
+
+double CemrgIntensityStats::GetMean() const {
+
+    return mean;
+}
+
+double CemrgIntensityStats::GetStdDev() const {
+
+    return stdDev;
+}
+
+double CemrgIntensityStats::GetMin() const {
+
+    return minValue;
+}
+
+double CemrgIntensityStats::GetMax() const {
+
+    return maxValue;
+}
+
+double CemrgIntensityStats::GetPercentile(double fraction) const {
+
+    if (count == 0)
+        return 0;
+
+    //Nearest rank in the ascending order
+    long long rank = (long long)std::floor(std::max(0.0, std::min(1.0, fraction)) * (count - 1));
+    long long seen = 0;
+    for (size_t b=0; b<histogram.size(); b++) {
+        seen += histogram[b];
+        if (seen > rank)
+            return minValue + (int)b;
+    }//_for
+    return maxValue;
+}
+
+double CemrgIntensityStats::GetTopMean(double fraction) const {
+
+    if (count == 0)
+        return 0;
+
+    //Brightest k values, ties at the cut are split
+    long long k = count - (long long)(count * (1.0 - std::max(0.0, std::min(1.0, fraction))));
+    k = std::max(1LL, std::min(count, k));
+    long long remaining = k;
+    double sum = 0;
+    for (size_t b=histogram.size(); b-- > 0 && remaining > 0;) {
+        long long taken = std::min(remaining, histogram[b]);
+        sum += (double)taken * (minValue + (int)b);
+        remaining -= taken;
+    }//_for
+    return sum / k;
+}
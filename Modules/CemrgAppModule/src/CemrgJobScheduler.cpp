@@ -0,0 +1,208 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Job Scheduler for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkLogMacros.h>
+
+//Std
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+#include "CemrgJobScheduler.h"
+
+
+CemrgJobScheduler* CemrgJobScheduler::GetInstance() {
+
+    static CemrgJobScheduler instance;
+    return &instance;
+}
+
+CemrgJobScheduler::CemrgJobScheduler() {
+
+    busyThreads = 0;
+    runningJobs = 0;
+    cpuBudget = std::max(1, (int)std::thread::hardware_concurrency());
+
+    //User override of the budget
+    const char* envBudget = std::getenv("CEMRG_CPU_BUDGET");
+    if (envBudget != NULL && std::atoi(envBudget) > 0)
+        cpuBudget = std::atoi(envBudget);
+    MITK_INFO << "CPU budget for external tools and workers: " << cpuBudget;
+}
+
+int CemrgJobScheduler::GetCpuBudget() const {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return cpuBudget;
+}
+
+void CemrgJobScheduler::SetCpuBudget(int cores) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    cpuBudget = std::max(1, cores);
+    released.notify_all();
+    Dispatch();
+}
+
+int CemrgJobScheduler::GetIdleThreads() const {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::max(0, cpuBudget - busyThreads);
+}
+
+int CemrgJobScheduler::ThreadsPerJob(int noJobs) const {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::max(1, cpuBudget / std::max(1, noJobs));
+}
+
+int CemrgJobScheduler::AcquireThreads(int requested, int minimum) {
+
+    std::unique_lock<std::mutex> lock(mutex);
+    minimum = std::max(1, std::min(minimum, cpuBudget));
+    requested = std::max(minimum, std::min(requested, cpuBudget));
+    released.wait(lock, [&]() { return cpuBudget - busyThreads >= minimum; });
+
+    int granted = std::min(requested, cpuBudget - busyThreads);
+    busyThreads += granted;
+    return granted;
+}
+
+int CemrgJobScheduler::TryAcquireThreads(int requested) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    int granted = std::max(0, std::min(requested, cpuBudget - busyThreads));
+    busyThreads += granted;
+    return granted;
+}
+
+void CemrgJobScheduler::ReleaseThreads(int threads) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    busyThreads = std::max(0, busyThreads - threads);
+    released.notify_all();
+    Dispatch();
+}
+
+std::shared_future<void> CemrgJobScheduler::Submit(std::function<void(int)> job, int requested) {
+
+    Job entry;
+    entry.task = job;
+    entry.requested = std::max(1, requested);
+    entry.done = std::make_shared<std::promise<void>>();
+    std::shared_future<void> future = entry.done->get_future().share();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingJobs.push_back(entry);
+    Dispatch();
+    return future;
+}
+
+void CemrgJobScheduler::WaitForAll() {
+
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [&]() { return pendingJobs.empty() && runningJobs == 0; });
+}
+
+void CemrgJobScheduler::ParallelFor(int count, std::function<void(int, int)> body, int grain) {
+
+    if (count <= 0)
+        return;
+
+    //The calling thread works too, helpers only take threads that are idle
+    int chunks = std::max(1, count / std::max(1, grain));
+    int helpers = GetInstance()->TryAcquireThreads(chunks - 1);
+    int threads = helpers + 1;
+    int step = (count + threads - 1) / threads;
+
+    std::vector<std::thread> workers;
+    for (int t=1; t<threads; t++) {
+        int begin = t * step;
+        int end = std::min(count, begin + step);
+        if (begin < end)
+            workers.push_back(std::thread(body, begin, end));
+    }//_for
+    body(0, std::min(count, step));
+    for (size_t t=0; t<workers.size(); t++)
+        workers[t].join();
+    GetInstance()->ReleaseThreads(helpers);
+}
+
+/********************************************
+ *        Private Members Defintions        *
+ ********************************************/
+
+void CemrgJobScheduler::Dispatch() {
+
+    //Called with the mutex held, jobs start in submission order
+    while (!pendingJobs.empty()) {
+
+        Job entry = pendingJobs.front();
+        int needed = std::min(entry.requested, cpuBudget);
+        if (cpuBudget - busyThreads < needed)
+            break;
+
+        pendingJobs.pop_front();
+        busyThreads += needed;
+        runningJobs++;
+
+        std::thread worker([this, entry, needed]() {
+            try {
+                entry.task(needed);
+                entry.done->set_value();
+            } catch(...) {
+                entry.done->set_exception(std::current_exception());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            busyThreads = std::max(0, busyThreads - needed);
+            runningJobs--;
+            released.notify_all();
+            Dispatch();
+        });
+        worker.detach();
+    }//_while
+}
+
+/********************************************
+ *          Reservation Defintions          *
+ ********************************************/
+
+CemrgJobScheduler::Reservation::Reservation(int requested, int minimum) {
+
+    threads = CemrgJobScheduler::GetInstance()->AcquireThreads(requested, minimum);
+}
+
+CemrgJobScheduler::Reservation::~Reservation() {
+
+    CemrgJobScheduler::GetInstance()->ReleaseThreads(threads);
+}
+
+int CemrgJobScheduler::Reservation::GetThreads() const {
+
+    return threads;
+}
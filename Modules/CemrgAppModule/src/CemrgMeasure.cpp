@@ -27,16 +27,29 @@ PURPOSE.  See the above copyright notices for more information.
 =========================================================================*/
 
 //Vtk
+#include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
 #include <vtkMath.h>
 #include <vtkIdList.h>
-#include <vtkMassProperties.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataReader.h>
+#include <vtkPolyDataWriter.h>
 
 //Qmitk
 #include <mitkIOUtil.h>
+#include <mitkLogMacros.h>
+
+//Std
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
 
 //Qt
 #include "CemrgMeasure.h"
+#include "CemrgCommandLine.h"
+#include "CemrgJobScheduler.h"
 
 
 void CemrgMeasure::Convert(QString dir, mitk::DataNode::Pointer node) {
@@ -44,66 +57,41 @@ void CemrgMeasure::Convert(QString dir, mitk::DataNode::Pointer node) {
     mitk::BaseData::Pointer data = node->GetData();
     mitk::PointSet::Pointer set = dynamic_cast<mitk::PointSet*>(data.GetPointer());
 
-    int items = 0;
-    for (mitk::PointSet::PointsIterator it = set->Begin(); it != set->End(); ++it) {
-        items++;
-    }
-
-    ofstream file;
-    double x, y, z;
-    file.open(dir.toStdString() + mitk::IOUtil::GetDirectorySeparator() + "input.vtk");
-
-    //Header
-    file << "# vtk DataFile Version 3.0" << endl;
-    file << "vtk output" << endl;
-    file << "ASCII" << endl;
-    file << "DATASET POLYDATA" << endl;
-    file << "POINTS " << items << " float" << endl;
-
-    //Body
-    items = 0;
+    //Points for MIRTK
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
     for (mitk::PointSet::PointsIterator it = set->Begin(); it != set->End(); ++it) {
-        x = it.Value().GetElement(0) * -1;
-        y = it.Value().GetElement(1) * -1;
-        z = it.Value().GetElement(2);
-        items+=3;
-
-        file << x << " " << y << " " << z << " ";
-        if (items%9==0)
-            file << endl;
+        double x = it.Value().GetElement(0) * -1;
+        double y = it.Value().GetElement(1) * -1;
+        double z = it.Value().GetElement(2);
+        points->InsertNextPoint(x, y, z);
     }//for
-    file.close();
+    vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+    pd->SetPoints(points);
+
+    //Binary legacy unless ASCII is requested for compatibility
+    vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+    writer->SetFileName((dir.toStdString() + mitk::IOUtil::GetDirectorySeparator() + "input.vtk").c_str());
+    writer->SetInputData(pd);
+    if (CemrgCommandLine::GetVtkAsciiOutput())
+        writer->SetFileTypeToASCII();
+    else
+        writer->SetFileTypeToBinary();
+    writer->Write();
 }
 
 std::vector <std::tuple<double, double, double>> CemrgMeasure::Deconvert(QString dir, int noFile) {
 
-    double x, y, z;
-    std::string line;
-    unsigned int items;
-    std::vector<std::string> tokens;
     std::vector <std::tuple<double, double, double>> points;
-    ifstream file(dir.toStdString() + mitk::IOUtil::GetDirectorySeparator() + "transformed-" + std::to_string(noFile) + ".vtk");
-
-    if (file.is_open()) {
-
-        //Skip header
-        for (int i=0; i<5; i++)
-            getline(file,line);
-
-        //Read main
-        while (getline(file,line)) {
-            items = 0;
-            tokens = Split(line,tokens);
-            while (items<tokens.size()) {
-                x = std::stod(tokens.at(items + 0)) * -1;
-                y = std::stod(tokens.at(items + 1)) * -1;
-                z = std::stod(tokens.at(items + 2));
-                items+=3;
-                points.push_back(std::tuple<double, double, double>(x,y,z));
-            }
-        }
-        file.close();
-    }//_if
+    std::string path = dir.toStdString() + mitk::IOUtil::GetDirectorySeparator() + "transformed-" + std::to_string(noFile) + ".vtk";
+
+    //Reads both binary and ASCII legacy files, MIRTK to MITK flip included
+    if (!pointReader.Read(QString::fromStdString(path)))
+        return points;
+
+    const std::vector<double>& coords = pointReader.GetCoordinates();
+    points.reserve(pointReader.GetNumberOfPoints());
+    for (size_t i=0; i<coords.size(); i+=3)
+        points.push_back(std::tuple<double, double, double>(coords[i], coords[i+1], coords[i+2]));
 
     return points;
 }
@@ -178,52 +166,211 @@ mitk::Point3D CemrgMeasure::FindCentre(mitk::PointSet::Pointer pointset) {
     return centrePoint;
 }
 
-double CemrgMeasure::GetSphericity(vtkPolyData* LAC_poly) {
-
-    double LACA;
-    double LAC_mc[3];
-    double AR, sigma, Sphericity;
+CemrgMeasure::ShapeMetrics CemrgMeasure::GetShapeMetrics(vtkPolyData* poly) {
+
+    ShapeMetrics metrics = {0.0, 0.0, {0.0, 0.0, 0.0}, 0.0, 0.0, 0.0, false};
+
+    //Contiguous copies of the points and polygon connectivity
+    vtkIdType noPts = poly->GetNumberOfPoints();
+    std::vector<double> points(3*noPts);
+    for (vtkIdType i=0; i<noPts; i++)
+        poly->GetPoint(i, &points[3*i]);
+    std::vector<vtkIdType> offsets(1, 0), ids;
+    vtkIdType npts;
+    vtkIdType* pts;
+    vtkCellArray* polys = poly->GetPolys();
+    for (polys->InitTraversal(); polys->GetNextCell(npts, pts); ) {
+        ids.insert(ids.end(), pts, pts + npts);
+        offsets.push_back(ids.size());
+    }//_for
+    int noCells = offsets.size() - 1;
+    if (noCells == 0)
+        return metrics;
+
+    //Fixed blocks, so sums do not depend on how many threads ran
+    const int blockSize = 4096;
+    int noBlocks = (noCells + blockSize - 1) / blockSize;
+    auto cellCentre = [&](int cell, double* centre) {
+        centre[0] = centre[1] = centre[2] = 0;
+        for (vtkIdType j=offsets[cell]; j<offsets[cell+1]; j++)
+            for (int a=0; a<3; a++)
+                centre[a] += points[3*ids[j]+a];
+        for (int a=0; a<3; a++)
+            centre[a] /= (offsets[cell+1] - offsets[cell]);
+    };
+
+    //First pass: area, enclosed volume and area weighted centroid
+    std::vector<double> sums1(5*noBlocks, 0.0);
+    CemrgJobScheduler::ParallelFor(noBlocks, [&](int begin, int end) {
+        for (int block=begin; block<end; block++) {
+            double* sum = &sums1[5*block];
+            for (int cell=block*blockSize; cell<std::min(noCells, (block+1)*blockSize); cell++) {
+                double centre[3], cellArea = 0;
+                const double* p0 = &points[3*ids[offsets[cell]]];
+                for (vtkIdType j=offsets[cell]+1; j+1<offsets[cell+1]; j++) {
+                    const double* p1 = &points[3*ids[j]];
+                    const double* p2 = &points[3*ids[j+1]];
+                    double e1[3] = {p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]};
+                    double e2[3] = {p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2]};
+                    double cross[3], p1xp2[3];
+                    vtkMath::Cross(e1, e2, cross);
+                    cellArea += 0.5 * vtkMath::Norm(cross);
+                    vtkMath::Cross(p1, p2, p1xp2);
+                    sum[1] += vtkMath::Dot(p0, p1xp2) / 6.0;
+                }//_for
+                cellCentre(cell, centre);
+                sum[0] += cellArea;
+                for (int a=0; a<3; a++)
+                    sum[2+a] += cellArea * centre[a];
+            }//_for
+        }//_for
+    });
+    for (int block=0; block<noBlocks; block++) {
+        metrics.area += sums1[5*block];
+        metrics.volume += sums1[5*block+1];
+        for (int a=0; a<3; a++)
+            metrics.centroid[a] += sums1[5*block+2+a];
+    }//_for
+    metrics.volume = std::fabs(metrics.volume);
+    if (metrics.area == 0)
+        return metrics;
+    for (int a=0; a<3; a++)
+        metrics.centroid[a] /= metrics.area;
+
+    //Second pass: area weighted mean and spread of the cell distances to the centroid
+    std::vector<double> sums2(2*noBlocks, 0.0);
+    CemrgJobScheduler::ParallelFor(noBlocks, [&](int begin, int end) {
+        for (int block=begin; block<end; block++) {
+            double* sum = &sums2[2*block];
+            for (int cell=block*blockSize; cell<std::min(noCells, (block+1)*blockSize); cell++) {
+                double centre[3], cellArea = 0;
+                const double* p0 = &points[3*ids[offsets[cell]]];
+                for (vtkIdType j=offsets[cell]+1; j+1<offsets[cell+1]; j++) {
+                    const double* p1 = &points[3*ids[j]];
+                    const double* p2 = &points[3*ids[j+1]];
+                    double e1[3] = {p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]};
+                    double e2[3] = {p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2]};
+                    double cross[3];
+                    vtkMath::Cross(e1, e2, cross);
+                    cellArea += 0.5 * vtkMath::Norm(cross);
+                }//_for
+                cellCentre(cell, centre);
+                double distance = sqrt(vtkMath::Distance2BetweenPoints(centre, metrics.centroid));
+                sum[0] += cellArea * distance;
+                sum[1] += cellArea * distance * distance;
+            }//_for
+        }//_for
+    });
+    double meanDistance = 0, meanSquare = 0;
+    for (int block=0; block<noBlocks; block++) {
+        meanDistance += sums2[2*block];
+        meanSquare += sums2[2*block+1];
+    }//_for
+    metrics.meanRadius = meanDistance / metrics.area;
+    metrics.sigma = sqrt(std::max(0.0, meanSquare / metrics.area - metrics.meanRadius * metrics.meanRadius));
+    metrics.sphericity = 100 * (1 - metrics.sigma / metrics.meanRadius);
+    metrics.valid = true;
+    return metrics;
+}
 
-    //containers for centre of mass, area, etc.
-    double** TiMC;
-    double* TiA;
+double CemrgMeasure::GetSphericity(vtkPolyData* poly) {
 
-    TiMC = new double*[LAC_poly->GetNumberOfCells()];
-    for (int i=0; i<LAC_poly->GetNumberOfCells(); i++) {
-        TiMC[i] = new double[3];
-    }
+    return GetShapeMetrics(poly).sphericity;
+}
 
-    TiA = new double[LAC_poly->GetNumberOfCells()];
+CemrgMeasure::SeriesMetrics CemrgMeasure::GetSeriesMetrics(std::vector<vtkSmartPointer<vtkPolyData>> meshes) {
 
-    GetCentreOfMassOfEachT(LAC_poly, TiMC);
-    GetArea(LAC_poly, TiA, LACA);
-    GetCentreOfMass(TiMC, TiA, LAC_poly->GetNumberOfCells(), LACA, LAC_mc);
-    GetAverageRadius(TiMC, TiA, LAC_poly->GetNumberOfCells(), LAC_mc,  LACA, AR);
-    LASphericity(TiMC, TiA, LAC_poly->GetNumberOfCells(), LAC_mc, LACA, AR, sigma, Sphericity);
+    //Frames in flight concurrently, each may widen into idle threads
+    std::vector<ShapeMetrics> frames(meshes.size());
+    std::vector<std::shared_future<void>> jobs;
+    for (unsigned int i=0; i<meshes.size(); i++) {
+        vtkSmartPointer<vtkPolyData> mesh = meshes.at(i);
+        jobs.push_back(CemrgJobScheduler::GetInstance()->Submit([this, mesh, i, &frames](int) {
+            frames[i] = GetShapeMetrics(mesh);
+        }));
+    }//_for
+    for (unsigned int i=0; i<jobs.size(); i++)
+        jobs[i].get();
+    return SummariseSeries(frames);
+}
 
-    return Sphericity;
+CemrgMeasure::SeriesMetrics CemrgMeasure::GetSeriesMetrics(QString dir, int noFrames, QString prefix) {
+
+    //Loading and measuring of each frame form one job, so reads overlap computation
+    ShapeMetrics unread = {0.0, 0.0, {0.0, 0.0, 0.0}, 0.0, 0.0, 0.0, false};
+    std::vector<ShapeMetrics> frames(std::max(0, noFrames), unread);
+    std::vector<std::shared_future<void>> jobs;
+    for (int i=0; i<noFrames; i++) {
+        std::string path = (dir + mitk::IOUtil::GetDirectorySeparator() + prefix + QString::number(i) + ".vtk").toStdString();
+        jobs.push_back(CemrgJobScheduler::GetInstance()->Submit([this, path, i, &frames](int) {
+            vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+            reader->SetFileName(path.c_str());
+            reader->Update();
+            if (reader->GetErrorCode() != 0 || reader->GetOutput()->GetNumberOfPoints() == 0) {
+                MITK_WARN << "Frame " << i << " could not be read: " << path;
+                return;
+            }//_if
+            frames[i] = GetShapeMetrics(reader->GetOutput());
+        }));
+    }//_for
+    for (unsigned int i=0; i<jobs.size(); i++)
+        jobs[i].get();
+    return SummariseSeries(frames);
 }
 
 double CemrgMeasure::calcVolumeMesh(mitk::Surface::Pointer surface) {
 
-    vtkSmartPointer<vtkMassProperties> mass = vtkSmartPointer<vtkMassProperties>::New();
-    mass->SetInputData(surface->GetVtkPolyData());
-    mass->Update();
-    return mass->GetVolume();
+    return GetShapeMetrics(surface->GetVtkPolyData()).volume;
 }
 
 double CemrgMeasure::calcSurfaceMesh(mitk::Surface::Pointer surface) {
 
-    vtkSmartPointer<vtkMassProperties> mass = vtkSmartPointer<vtkMassProperties>::New();
-    mass->SetInputData(surface->GetVtkPolyData());
-    mass->Update();
-    return mass->GetSurfaceArea();
+    return GetShapeMetrics(surface->GetVtkPolyData()).area;
 }
 
 /********************************************
  *        Private Members Defintions        *
  ********************************************/
 
+CemrgMeasure::SeriesMetrics CemrgMeasure::SummariseSeries(std::vector<ShapeMetrics>& frames) {
+
+    SeriesMetrics series;
+    series.frames = frames;
+    series.edv = series.esv = series.strokeVolume = series.ef = 0;
+    series.edFrame = series.esFrame = series.maxSphericityFrame = series.minSphericityFrame = -1;
+    if (frames.empty())
+        return series;
+
+    //Frames that could not be measured would pose as the smallest volume
+    int first = -1;
+    for (unsigned int i=0; i<frames.size(); i++) {
+        if (!frames[i].valid) {
+            series.volumes.push_back(std::numeric_limits<double>::quiet_NaN());
+            series.invalidFrames.push_back(i);
+            continue;
+        }//_if
+        series.volumes.push_back(frames[i].volume);
+        if (first < 0) {
+            first = i;
+            series.edFrame = series.esFrame = series.maxSphericityFrame = series.minSphericityFrame = i;
+        }//_if
+        if (frames[i].volume > frames[series.edFrame].volume) series.edFrame = i;
+        if (frames[i].volume < frames[series.esFrame].volume) series.esFrame = i;
+        if (frames[i].sphericity > frames[series.maxSphericityFrame].sphericity) series.maxSphericityFrame = i;
+        if (frames[i].sphericity < frames[series.minSphericityFrame].sphericity) series.minSphericityFrame = i;
+    }//_for
+    if (!series.invalidFrames.empty())
+        MITK_WARN << series.invalidFrames.size() << " of " << frames.size() << " frames are invalid and left out of the series summary";
+    if (first < 0)
+        return series;
+
+    series.edv = frames[series.edFrame].volume;
+    series.esv = frames[series.esFrame].volume;
+    series.strokeVolume = series.edv - series.esv;
+    series.ef = series.edv > 0 ? 100 * series.strokeVolume / series.edv : 0;
+    return series;
+}
+
 std::tuple<double, double, double> CemrgMeasure::CalcMean(std::vector <std::tuple<double, double, double>>& points) {
 
     double x_s = 0;
@@ -285,122 +432,3 @@ std::vector<std::string>& CemrgMeasure::Split(const std::string& str, std::vecto
         elements.push_back(item);
     return elements;
 }
-
-void CemrgMeasure::GetArea(vtkPolyData* polys, double* TiA, double& LACA) {
-
-    double p1[3], p2[3], p3[3];
-    double p1_p2[3];		// p1 minus p2
-    double p2_p3[3];		// p2 minus p3
-    double crossProduct[3];
-    LACA = 0;
-    vtkSmartPointer<vtkIdList> cell_points = vtkSmartPointer<vtkIdList>::New();
-
-    for (int i=0; i<polys->GetNumberOfCells(); i++) {
-
-        //vtkIdType neighbor_point;
-        polys->GetCellPoints(i, cell_points);
-
-        // Get all three vertices
-        vtkIdType neighbor_point_id = cell_points->GetId(0);
-        polys->GetPoint( neighbor_point_id, p1);
-
-        neighbor_point_id = cell_points->GetId(1);
-        polys->GetPoint( neighbor_point_id, p2);
-
-        neighbor_point_id = cell_points->GetId(2);
-        polys->GetPoint( neighbor_point_id, p3);
-
-        vtkMath::Subtract(p1, p2, p1_p2);
-        vtkMath::Subtract(p2, p3, p2_p3);
-
-        vtkMath::Cross(p1_p2, p2_p3, crossProduct);
-        TiA[i] = 0.5*vtkMath::Norm(crossProduct);
-        LACA += TiA[i];
-    }
-    cout << "Total area LACA = " << LACA << endl;
-}
-
-void CemrgMeasure::GetCentreOfMass(double** TiMC, double* TiA, int TiMC_size, double LACA, double* LAC_mc) {
-
-    LAC_mc[0] = 0; LAC_mc[1] = 0; LAC_mc[2] = 0;
-    double contrib;
-
-    for (int i=0; i<TiMC_size; i++) {
-
-        contrib = TiA[i]/LACA;
-        LAC_mc[0]+=(contrib)*TiMC[i][0];
-        LAC_mc[1]+=(contrib)*TiMC[i][1];
-        LAC_mc[2]+=(contrib)*TiMC[i][2];
-    }
-}
-
-void CemrgMeasure::GetCentreOfMassOfEachT(vtkPolyData* polys, double** TiMC) {
-
-    int num_points = 0;
-    vtkIdType num_cell_points;
-    double cX, cY, cZ;
-    double cP[3];
-    vtkSmartPointer<vtkIdList> cell_points = vtkSmartPointer<vtkIdList>::New();
-
-    for (int i=0; i<polys->GetNumberOfCells(); i++) {
-
-        cX=0; cY=0; cZ=0; num_points=0;
-        vtkIdType neighbor_point;
-        polys->GetCellPoints(i, cell_points);
-        num_cell_points = cell_points->GetNumberOfIds();
-
-        for (neighbor_point = 0; neighbor_point < num_cell_points; ++neighbor_point) {
-
-            // Get the neighbour point id
-            vtkIdType neighbor_point_id = cell_points->GetId(neighbor_point);
-            // Get the neighbour point position
-            polys->GetPoint( neighbor_point_id, cP );
-            cX+=cP[0]; cY+=cP[1]; cZ+=cP[2];
-            num_points++;
-        }
-        cX/=num_points;
-        cY/=num_points;
-        cZ/=num_points;
-        TiMC[i][0] = cX;
-        TiMC[i][1] = cY;
-        TiMC[i][2] = cZ;
-    }
-}
-
-void CemrgMeasure::GetAverageRadius(double** TiMC, double* TiA, double TiMC_size, double* LAC_mc, double LACA, double& AR) {
-
-    double contrib;
-    double a[3], b[3], a_minus_b[3];
-    AR = 0;
-
-    for (int i=0; i<TiMC_size; i++) {
-
-        a[0] = LAC_mc[0]; a[1] = LAC_mc[1]; a[2] = LAC_mc[2];
-        b[0] = TiMC[i][0]; b[1] = TiMC[i][1]; b[2] = TiMC[i][2];
-        vtkMath::Subtract(a,b,a_minus_b);
-        contrib = TiA[i]/LACA;
-        AR += contrib*vtkMath::Norm(a_minus_b);
-    }
-}
-
-void CemrgMeasure::LASphericity(
-        double** TiMC, double* TiA, double TiMC_size, double* LAC_mc, double LACA, double AR, double& sigma, double& Sphericity) {
-
-    double contrib;
-    double a[3], b[3], a_minus_b[3];
-    double phi=0, eps=0, CVS=0;
-
-    for (int i=0; i<TiMC_size; i++) {
-
-        contrib = TiA[i]/LACA;
-        a[0] = LAC_mc[0]; a[1] = LAC_mc[1]; a[2] = LAC_mc[2];
-        b[0] = TiMC[i][0]; b[1] = TiMC[i][1]; b[2] = TiMC[i][2];
-        vtkMath::Subtract(a,b,a_minus_b);
-        phi = (vtkMath::Norm(a_minus_b) - AR)*(vtkMath::Norm(a_minus_b) - AR);
-        eps += contrib*phi;
-    }
-
-    sigma = sqrt(eps);
-    CVS = sigma/AR;
-    Sphericity = 100*(1-CVS);
-}
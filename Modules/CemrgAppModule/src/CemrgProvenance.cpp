@@ -0,0 +1,164 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Provenance Journal for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkLogMacros.h>
+
+//VTK
+#include <vtkPolyDataWriter.h>
+
+//Std
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <cstdlib>
+#include <functional>
+#include <condition_variable>
+#include "CemrgCommandLine.h"
+#include "CemrgProvenance.h"
+
+namespace {
+
+    bool EnabledFromEnvironment() {
+        const char* value = std::getenv("CEMRG_PROVENANCE");
+        return value == NULL || std::string(value) != "0";
+    }
+
+    class ProvenanceWriter {
+
+    public:
+
+        static ProvenanceWriter* GetInstance() {
+            static ProvenanceWriter instance;
+            return &instance;
+        }
+
+        ~ProvenanceWriter() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            queued.notify_all();
+            if (worker.joinable())
+                worker.join();
+        }
+
+        void Push(std::function<void()> artifact) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!worker.joinable())
+                worker = std::thread(&ProvenanceWriter::Run, this);
+            pending.push_back(artifact);
+            queued.notify_one();
+        }
+
+        void Flush() {
+            std::unique_lock<std::mutex> lock(mutex);
+            written.wait(lock, [&]() { return pending.empty() && !writing; });
+        }
+
+    private:
+
+        ProvenanceWriter() : writing(false), stopping(false) {}
+
+        void Run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                queued.wait(lock, [&]() { return stopping || !pending.empty(); });
+                if (pending.empty())
+                    break;
+                std::function<void()> artifact = pending.front();
+                pending.pop_front();
+                writing = true;
+                lock.unlock();
+                try {
+                    artifact();
+                } catch(...) {
+                    MITK_WARN << "Provenance artifact could not be written.";
+                }
+                lock.lock();
+                writing = false;
+                written.notify_all();
+            }//_while
+        }
+
+        std::deque<std::function<void()>> pending;
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable written;
+        std::thread worker;
+        bool writing;
+        bool stopping;
+    };
+}
+
+std::atomic<bool> CemrgProvenance::enabled(EnabledFromEnvironment());
+
+void CemrgProvenance::SetEnabled(bool value) {
+
+    enabled.store(value);
+}
+
+void CemrgProvenance::WritePolyData(vtkSmartPointer<vtkPolyData> polyData, QString path) {
+
+    if (!IsEnabled() || polyData == NULL)
+        return;
+
+    vtkSmartPointer<vtkPolyData> copy = vtkSmartPointer<vtkPolyData>::New();
+    copy->DeepCopy(polyData);
+    std::string fileName = path.toStdString();
+    bool ascii = CemrgCommandLine::GetVtkAsciiOutput();
+    ProvenanceWriter::GetInstance()->Push([copy, fileName, ascii]() {
+        vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+        writer->SetInputData(copy);
+        writer->SetFileName(fileName.c_str());
+        if (ascii)
+            writer->SetFileTypeToASCII();
+        else
+            writer->SetFileTypeToBinary();
+        writer->Write();
+    });
+}
+
+void CemrgProvenance::WriteText(QString path, std::string content) {
+
+    if (!IsEnabled())
+        return;
+
+    std::string fileName = path.toStdString();
+    ProvenanceWriter::GetInstance()->Push([fileName, content]() {
+        std::ofstream file(fileName.c_str());
+        file << content;
+        file.close();
+    });
+}
+
+void CemrgProvenance::Flush() {
+
+    ProvenanceWriter::GetInstance()->Flush();
+}
@@ -0,0 +1,315 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Rigid Registration for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+#include <mitkProgressBar.h>
+#include <mitkLogMacros.h>
+
+//ITK
+#include <itkImageRegistrationMethodv4.h>
+#include <itkMattesMutualInformationImageToImageMetricv4.h>
+#include <itkRegularStepGradientDescentOptimizerv4.h>
+#include <itkRegistrationParameterScalesFromPhysicalShift.h>
+#include <itkCenteredTransformInitializer.h>
+#include <itkResampleImageFilter.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkTransformFileWriter.h>
+#include <itkTransformFileReader.h>
+#include <itkTransformFactory.h>
+
+//Qt
+#include <QFile>
+#include <QDataStream>
+
+//Std
+#include <cmath>
+#include <algorithm>
+#include "CemrgRegistration.h"
+#include "CemrgJobScheduler.h"
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+
+CemrgRegistration::CemrgRegistration() {
+
+    this->iterations = 200;
+    this->histogramBins = 50;
+    this->samplingPercentage = 0.20;
+    this->transform = RigidTransformType::New();
+}
+
+bool CemrgRegistration::RigidRegistration(mitk::Image::Pointer fixed, mitk::Image::Pointer moving) {
+
+    typedef itk::Image<float,3> ImageType;
+    typedef itk::MattesMutualInformationImageToImageMetricv4<ImageType, ImageType> MetricType;
+    typedef itk::RegularStepGradientDescentOptimizerv4<double> OptimizerType;
+    typedef itk::ImageRegistrationMethodv4<ImageType, ImageType, RigidTransformType> RegistrationType;
+    typedef itk::RegistrationParameterScalesFromPhysicalShift<MetricType> ScalesEstimatorType;
+    typedef itk::CenteredTransformInitializer<RigidTransformType, ImageType, ImageType> InitializerType;
+    typedef itk::ResampleImageFilter<ImageType, ImageType> ResampleImageFilterType;
+
+    //Cast to ITK
+    ImageType::Pointer fixedImage = ImageType::New();
+    ImageType::Pointer movingImage = ImageType::New();
+    mitk::CastToItkImage(fixed, fixedImage);
+    mitk::CastToItkImage(moving, movingImage);
+
+    try {
+
+        //Initial alignment of the geometric centres
+        RigidTransformType::Pointer initialTransform = RigidTransformType::New();
+        InitializerType::Pointer initializer = InitializerType::New();
+        initializer->SetTransform(initialTransform);
+        initializer->SetFixedImage(fixedImage);
+        initializer->SetMovingImage(movingImage);
+        initializer->GeometryOn();
+        initializer->InitializeTransform();
+
+        MetricType::Pointer metric = MetricType::New();
+        metric->SetNumberOfHistogramBins(histogramBins);
+
+        ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+        scalesEstimator->SetMetric(metric);
+        scalesEstimator->SetTransformForward(true);
+
+        OptimizerType::Pointer optimizer = OptimizerType::New();
+        optimizer->SetScalesEstimator(scalesEstimator);
+        optimizer->SetLearningRate(1.0);
+        optimizer->SetMinimumStepLength(0.001);
+        optimizer->SetRelaxationFactor(0.5);
+        optimizer->SetNumberOfIterations(iterations);
+        optimizer->SetReturnBestParametersAndValue(true);
+
+        //Pyramid of three levels as in MIRTK register
+        RegistrationType::ShrinkFactorsArrayType shrinkFactors(3);
+        shrinkFactors[0] = 4; shrinkFactors[1] = 2; shrinkFactors[2] = 1;
+        RegistrationType::SmoothingSigmasArrayType smoothingSigmas(3);
+        smoothingSigmas[0] = 2; smoothingSigmas[1] = 1; smoothingSigmas[2] = 0;
+
+        CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
+        RegistrationType::Pointer registration = RegistrationType::New();
+        registration->SetFixedImage(fixedImage);
+        registration->SetMovingImage(movingImage);
+        registration->SetMetric(metric);
+        registration->SetOptimizer(optimizer);
+        registration->SetInitialTransform(initialTransform);
+        registration->InPlaceOn();
+        registration->SetNumberOfLevels(3);
+        registration->SetShrinkFactorsPerLevel(shrinkFactors);
+        registration->SetSmoothingSigmasPerLevel(smoothingSigmas);
+        registration->SetSmoothingSigmasAreSpecifiedInPhysicalUnits(false);
+        registration->SetMetricSamplingStrategy(RegistrationType::RANDOM);
+        registration->SetMetricSamplingPercentage(samplingPercentage);
+        registration->MetricSamplingReinitializeSeed(121212);
+        registration->SetNumberOfThreads(cpus.GetThreads());
+        registration->Update();
+
+        transform = RigidTransformType::New();
+        transform->SetFixedParameters(registration->GetTransform()->GetFixedParameters());
+        transform->SetParameters(registration->GetTransform()->GetParameters());
+        MITK_INFO << "Rigid registration finished after " << optimizer->GetCurrentIteration()
+                  << " iterations with metric value " << optimizer->GetValue();
+
+        //Moving image in the fixed image space
+        ResampleImageFilterType::Pointer resampler = ResampleImageFilterType::New();
+        resampler->SetInput(movingImage);
+        resampler->SetTransform(transform);
+        resampler->SetUseReferenceImage(true);
+        resampler->SetReferenceImage(fixedImage);
+        resampler->SetDefaultPixelValue(0);
+        resampler->SetNumberOfThreads(cpus.GetThreads());
+        resampler->Update();
+        resampledImage = mitk::ImportItkImage(resampler->GetOutput())->Clone();
+
+    } catch (itk::ExceptionObject& err) {
+        MITK_ERROR << "Rigid registration failed: " << err;
+        return false;
+    }//_try
+
+    mitk::ProgressBar::GetInstance()->Progress();
+    return true;
+}
+
+mitk::Image::Pointer CemrgRegistration::TransformImage(mitk::Image::Pointer image, bool labelImage) {
+
+    //Same lattice as the input, as transform-image without a target
+    CemrgJobScheduler::Reservation cpus(CemrgJobScheduler::GetInstance()->GetCpuBudget());
+    mitk::Image::Pointer output;
+
+    if (labelImage) {
+
+        typedef itk::Image<short,3> ImageType;
+        typedef itk::ResampleImageFilter<ImageType, ImageType> ResampleImageFilterType;
+        typedef itk::NearestNeighborInterpolateImageFunction<ImageType, double> NearestInterpolatorType;
+
+        ImageType::Pointer itkImage = ImageType::New();
+        mitk::CastToItkImage(image, itkImage);
+        ResampleImageFilterType::Pointer resampler = ResampleImageFilterType::New();
+        resampler->SetInput(itkImage);
+        resampler->SetTransform(transform);
+        resampler->SetInterpolator(NearestInterpolatorType::New());
+        resampler->SetUseReferenceImage(true);
+        resampler->SetReferenceImage(itkImage);
+        resampler->SetDefaultPixelValue(0);
+        resampler->SetNumberOfThreads(cpus.GetThreads());
+        resampler->Update();
+        output = mitk::ImportItkImage(resampler->GetOutput())->Clone();
+
+    } else {
+
+        typedef itk::Image<float,3> ImageType;
+        typedef itk::ResampleImageFilter<ImageType, ImageType> ResampleImageFilterType;
+        typedef itk::LinearInterpolateImageFunction<ImageType, double> LinearInterpolatorType;
+
+        ImageType::Pointer itkImage = ImageType::New();
+        mitk::CastToItkImage(image, itkImage);
+        ResampleImageFilterType::Pointer resampler = ResampleImageFilterType::New();
+        resampler->SetInput(itkImage);
+        resampler->SetTransform(transform);
+        resampler->SetInterpolator(LinearInterpolatorType::New());
+        resampler->SetUseReferenceImage(true);
+        resampler->SetReferenceImage(itkImage);
+        resampler->SetDefaultPixelValue(0);
+        resampler->SetNumberOfThreads(cpus.GetThreads());
+        resampler->Update();
+        output = mitk::ImportItkImage(resampler->GetOutput())->Clone();
+
+    }//_if
+
+    mitk::ProgressBar::GetInstance()->Progress();
+    return output;
+}
+
+bool CemrgRegistration::SaveTransform(QString path) {
+
+    typedef itk::TransformFileWriterTemplate<double> TransformWriterType;
+    TransformWriterType::Pointer writer = TransformWriterType::New();
+    writer->SetInput(transform);
+    writer->SetFileName(path.toStdString());
+
+    try {
+        writer->Update();
+    } catch (itk::ExceptionObject& err) {
+        MITK_ERROR << "Transform could not be written: " << err;
+        return false;
+    }//_try
+    return true;
+}
+
+bool CemrgRegistration::LoadTransform(QString path) {
+
+    typedef itk::TransformFileReaderTemplate<double> TransformReaderType;
+    itk::TransformFactory<RigidTransformType>::RegisterTransform();
+    TransformReaderType::Pointer reader = TransformReaderType::New();
+    reader->SetFileName(path.toStdString());
+
+    try {
+        reader->Update();
+    } catch (itk::ExceptionObject& err) {
+        MITK_ERROR << "Transform could not be read: " << err;
+        return false;
+    }//_try
+
+    if (reader->GetTransformList()->empty())
+        return false;
+    RigidTransformType* rigid = dynamic_cast<RigidTransformType*>(reader->GetTransformList()->front().GetPointer());
+    if (rigid == NULL)
+        return false;
+
+    transform = RigidTransformType::New();
+    transform->SetFixedParameters(rigid->GetFixedParameters());
+    transform->SetParameters(rigid->GetParameters());
+    return true;
+}
+
+bool CemrgRegistration::SaveMIRTKDof(QString path) {
+
+    //ITK world coordinates are LPS, MIRTK flips x and y
+    RigidTransformType::MatrixType M = transform->GetMatrix();
+    RigidTransformType::OffsetType o = transform->GetOffset();
+    const double flip[3] = {-1, -1, 1};
+    double A[3][3], t[3];
+    for (int i=0; i<3; i++) {
+        t[i] = flip[i] * o[i];
+        for (int j=0; j<3; j++)
+            A[i][j] = flip[i] * M(i,j) * flip[j];
+    }//_for
+
+    //Euler angles of the rigid parametrisation
+    double ry = std::asin(std::max(-1.0, std::min(1.0, -A[0][2])));
+    double rx = std::atan2(A[1][2], A[2][2]);
+    double rz = std::atan2(A[0][1], A[0][0]);
+    double dofs[6] = {t[0], t[1], t[2], rx*180.0/M_PI, ry*180.0/M_PI, rz*180.0/M_PI};
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        MITK_ERROR << ("Transformation file could not be written: " + path).toStdString();
+        return false;
+    }//_if
+
+    //Legacy binary layout, big endian: magic, type, number of dofs, dofs
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::BigEndian);
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    out << (quint32)815007 << (quint32)2 << (quint32)6;
+    for (int i=0; i<6; i++)
+        out << dofs[i];
+    file.close();
+
+    return out.status() == QDataStream::Ok;
+}
+
+mitk::Image::Pointer CemrgRegistration::GetResampledImage() const {
+
+    return resampledImage;
+}
+
+CemrgRegistration::RigidTransformType::Pointer CemrgRegistration::GetTransform() const {
+
+    return transform;
+}
+
+void CemrgRegistration::SetNumberOfIterations(int value) {
+
+    this->iterations = value;
+}
+
+void CemrgRegistration::SetNumberOfHistogramBins(int value) {
+
+    this->histogramBins = value;
+}
+
+void CemrgRegistration::SetSamplingPercentage(double value) {
+
+    this->samplingPercentage = value;
+}
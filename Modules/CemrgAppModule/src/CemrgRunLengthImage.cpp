@@ -0,0 +1,238 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Run-Length Label Images for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+
+//Std
+#include <algorithm>
+
+#include "CemrgRunLengthImage.h"
+#include "CemrgJobScheduler.h"
+
+
+CemrgRunLengthImage::CemrgRunLengthImage() {
+}
+
+CemrgRunLengthImage::CemrgRunLengthImage(ImageType::Pointer image) {
+
+    SetImage(image);
+}
+
+CemrgRunLengthImage::CemrgRunLengthImage(mitk::Image::Pointer image) {
+
+    SetImage(image);
+}
+
+void CemrgRunLengthImage::SetImage(ImageType::Pointer image) {
+
+    runs.clear();
+    labels.clear();
+    header = NULL;
+    if (image.IsNull())
+        return;
+
+    //Geometry only, the header never holds pixels
+    ImageType::RegionType region = image->GetBufferedRegion();
+    header = ImageType::New();
+    header->CopyInformation(image);
+    header->SetRegions(region);
+
+    //Rows are encoded per slice concurrently and joined in slice order
+    ImageType::SizeType size = region.GetSize();
+    ImageType::IndexType start = region.GetIndex();
+    const ImageType::PixelType* buffer = image->GetBufferPointer();
+    std::vector<std::vector<Run>> sliceRuns(size[2]);
+    CemrgJobScheduler::ParallelFor(size[2], [&](int begin, int end) {
+        for (int z=begin; z<end; z++) {
+            for (unsigned int y=0; y<size[1]; y++) {
+                const ImageType::PixelType* row = buffer + (z * size[1] + y) * size[0];
+                unsigned int x = 0;
+                while (x < size[0]) {
+                    short label = row[x];
+                    if (label == 0) {
+                        x++;
+                        continue;
+                    }//_if
+                    unsigned int x0 = x;
+                    while (x < size[0] && row[x] == label)
+                        x++;
+                    Run run;
+                    run.x = start[0] + x0;
+                    run.y = start[1] + y;
+                    run.z = start[2] + z;
+                    run.length = x - x0;
+                    run.label = label;
+                    sliceRuns[z].push_back(run);
+                }//_while
+            }//_for
+        }//_for
+    });
+
+    size_t noRuns = 0;
+    for (size_t z=0; z<sliceRuns.size(); z++)
+        noRuns += sliceRuns[z].size();
+    runs.reserve(noRuns);
+    for (size_t z=0; z<sliceRuns.size(); z++)
+        runs.insert(runs.end(), sliceRuns[z].begin(), sliceRuns[z].end());
+
+    //Label statistics from the runs only
+    for (size_t i=0; i<runs.size(); i++) {
+        const Run& run = runs[i];
+        std::map<short, LabelInfo>::iterator it = labels.find(run.label);
+        if (it == labels.end()) {
+            LabelInfo info;
+            info.voxels = 0;
+            info.min[0] = run.x; info.min[1] = run.y; info.min[2] = run.z;
+            info.max = info.min;
+            it = labels.insert(std::make_pair(run.label, info)).first;
+        }//_if
+        LabelInfo& info = it->second;
+        info.voxels += run.length;
+        info.min[0] = std::min<ImageType::IndexValueType>(info.min[0], run.x);
+        info.min[1] = std::min<ImageType::IndexValueType>(info.min[1], run.y);
+        info.min[2] = std::min<ImageType::IndexValueType>(info.min[2], run.z);
+        info.max[0] = std::max<ImageType::IndexValueType>(info.max[0], run.x + run.length - 1);
+        info.max[1] = std::max<ImageType::IndexValueType>(info.max[1], run.y);
+        info.max[2] = std::max<ImageType::IndexValueType>(info.max[2], run.z);
+    }//_for
+}
+
+void CemrgRunLengthImage::SetImage(mitk::Image::Pointer image) {
+
+    if (image.IsNull()) {
+        SetImage(ImageType::Pointer());
+        return;
+    }//_if
+    ImageType::Pointer itkImage = ImageType::New();
+    mitk::CastToItkImage(image, itkImage);
+    SetImage(itkImage);
+}
+
+CemrgRunLengthImage::ImageType::Pointer CemrgRunLengthImage::GetItkImage() const {
+
+    std::vector<short> runLabels(runs.size());
+    for (size_t i=0; i<runs.size(); i++)
+        runLabels[i] = runs[i].label;
+    return GetItkImage(runLabels);
+}
+
+CemrgRunLengthImage::ImageType::Pointer CemrgRunLengthImage::GetItkImage(const std::vector<short>& runLabels) const {
+
+    if (header.IsNull() || runLabels.size() != runs.size())
+        return NULL;
+
+    ImageType::Pointer image = ImageType::New();
+    image->CopyInformation(header);
+    image->SetRegions(header->GetBufferedRegion());
+    image->Allocate();
+    image->FillBuffer(0);
+
+    //Runs never overlap, so they are written concurrently
+    ImageType::PixelType* buffer = image->GetBufferPointer();
+    CemrgJobScheduler::ParallelFor(runs.size(), [&](int begin, int end) {
+        for (int i=begin; i<end; i++) {
+            if (runLabels[i] == 0)
+                continue;
+            ImageType::PixelType* first = buffer + GetOffset(runs[i]);
+            std::fill(first, first + runs[i].length, runLabels[i]);
+        }//_for
+    }, 4096);
+    return image;
+}
+
+mitk::Image::Pointer CemrgRunLengthImage::GetMitkImage() const {
+
+    ImageType::Pointer image = GetItkImage();
+    if (image.IsNull())
+        return NULL;
+    return mitk::GrabItkImageMemory(image);
+}
+
+const std::vector<CemrgRunLengthImage::Run>& CemrgRunLengthImage::GetRuns() const {
+
+    return runs;
+}
+
+CemrgRunLengthImage::ImageType::RegionType CemrgRunLengthImage::GetRegion() const {
+
+    if (header.IsNull())
+        return ImageType::RegionType();
+    return header->GetBufferedRegion();
+}
+
+CemrgRunLengthImage::ImageType::OffsetValueType CemrgRunLengthImage::GetOffset(const Run& run) const {
+
+    ImageType::IndexType index;
+    index[0] = run.x;
+    index[1] = run.y;
+    index[2] = run.z;
+    return header->ComputeOffset(index);
+}
+
+std::vector<short> CemrgRunLengthImage::GetLabels() const {
+
+    std::vector<short> values;
+    for (std::map<short, LabelInfo>::const_iterator it = labels.begin(); it != labels.end(); ++it)
+        values.push_back(it->first);
+    return values;
+}
+
+long long CemrgRunLengthImage::GetVoxelCount(short label) const {
+
+    std::map<short, LabelInfo>::const_iterator it = labels.find(label);
+    return it == labels.end() ? 0 : it->second.voxels;
+}
+
+long long CemrgRunLengthImage::GetForegroundCount() const {
+
+    long long voxels = 0;
+    for (std::map<short, LabelInfo>::const_iterator it = labels.begin(); it != labels.end(); ++it)
+        voxels += it->second.voxels;
+    return voxels;
+}
+
+bool CemrgRunLengthImage::GetBoundingBox(short label, ImageType::RegionType& box) const {
+
+    std::map<short, LabelInfo>::const_iterator it = labels.find(label);
+    if (it == labels.end())
+        return false;
+
+    ImageType::SizeType size;
+    for (int i=0; i<3; i++)
+        size[i] = it->second.max[i] - it->second.min[i] + 1;
+    box.SetIndex(it->second.min);
+    box.SetSize(size);
+    return true;
+}
+
+size_t CemrgRunLengthImage::GetMemorySize() const {
+
+    return runs.capacity() * sizeof(Run) + labels.size() * (sizeof(short) + sizeof(LabelInfo));
+}
@@ -58,6 +58,7 @@ PURPOSE.  See the above copyright notices for more information.
 #include <QMessageBox>
 #include <numeric>
 #include "CemrgScar3D.h"
+#include "CemrgTrace.h"
 
 
 CemrgScar3D::CemrgScar3D() {
@@ -124,6 +125,8 @@ mitk::Surface::Pointer CemrgScar3D::ClipMesh3D(mitk::Surface::Pointer surface, m
 
 mitk::Surface::Pointer CemrgScar3D::Scar3D(std::string directory, mitk::Image::Pointer lgeImage) {
 
+    CEMRG_TRACE_SCOPE("CemrgScar3D::Scar3D", QString::fromStdString(directory));
+
     //Convert to itk image
     itkImageType::Pointer scarImage;
     mitk::CastToItkImage(lgeImage, scarImage);
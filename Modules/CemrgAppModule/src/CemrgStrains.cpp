@@ -48,6 +48,7 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vtkRegularPolygonSource.h>
 
 #include "CemrgStrains.h"
+#include "CemrgTrace.h"
 #include <numeric>
 
 #ifndef M_PI
@@ -128,6 +129,8 @@ std::vector<double> CemrgStrains::CalculateSqzPlot(int meshNo) {
 
 std::vector<double> CemrgStrains::CalculateStrainsPlot(int meshNo, mitk::DataNode::Pointer lmNode, int flag) {
 
+    CEMRG_TRACE_SCOPE("CemrgStrains::CalculateStrainsPlot", projectDirectory);
+
     /**
      * Test Strains
      **/
@@ -0,0 +1,186 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Timing Trace for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkLogMacros.h>
+#include <mitkIOUtil.h>
+
+//Qt
+#include <QFile>
+#include <QTextStream>
+#include <QCoreApplication>
+
+//Std
+#include <map>
+#include <set>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "CemrgTrace.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+    struct TraceEvent {
+        std::string name;
+        long long start;
+        long long duration;
+        int tid;
+        long long processPeakRssKb;
+        long long peakRssGrowthKb;
+        long long childPeakRssKb;
+    };
+
+    //Events not yet on disk and the trace files opened by this process
+    std::mutex traceMutex;
+    std::map<QString, std::vector<TraceEvent>> traceEvents;
+    std::set<QString> traceFiles;
+    std::atomic<int> traceThreads(0);
+    thread_local int traceDepth = 0;
+    thread_local int traceTid = -1;
+
+    long long NowMicroseconds() {
+        static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void PeakMemory(long long& selfKb, long long& childrenKb) {
+        selfKb = 0, childrenKb = 0;
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            selfKb = counters.PeakWorkingSetSize / 1024;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            selfKb = usage.ru_maxrss;
+        if (getrusage(RUSAGE_CHILDREN, &usage) == 0)
+            childrenKb = usage.ru_maxrss;
+#if defined(__APPLE__)
+        //Reported in bytes on macOS
+        selfKb /= 1024, childrenKb /= 1024;
+#endif
+#endif
+    }
+
+    QString Escape(const std::string& text) {
+        QString escaped = QString::fromStdString(text);
+        escaped.replace("\\", "\\\\");
+        escaped.replace("\"", "\\\"");
+        return escaped;
+    }
+}
+
+std::atomic<bool> CemrgTrace::enabled(std::getenv("CEMRG_TRACE") != NULL);
+
+void CemrgTrace::SetEnabled(bool value) {
+
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void CemrgTrace::Flush(QString directory) {
+
+    //Appends pending events under the lock, every event is written once
+    std::lock_guard<std::mutex> lock(traceMutex);
+    std::map<QString, std::vector<TraceEvent>>::iterator it = traceEvents.find(directory);
+    if (it == traceEvents.end() || it->second.empty())
+        return;
+
+    //Array format, viewers accept it without the closing bracket
+    QString path = directory + mitk::IOUtil::GetDirectorySeparator() + "cemrgTrace.json";
+    bool opened = traceFiles.count(directory) > 0;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | (opened ? QIODevice::Append : QIODevice::Truncate))) {
+        MITK_WARN << ("Trace file could not be written: " + path).toStdString();
+        it->second.clear();
+        return;
+    }//_if
+
+    qint64 pid = QCoreApplication::applicationPid();
+    QTextStream out(&file);
+    if (!opened) {
+        out << "[\n";
+        traceFiles.insert(directory);
+    }//_if
+    for (size_t i = 0; i < it->second.size(); i++) {
+        const TraceEvent& event = it->second[i];
+        out << "{\"name\":\"" << Escape(event.name) << "\",\"cat\":\"cemrg\",\"ph\":\"X\""
+            << ",\"ts\":" << event.start << ",\"dur\":" << event.duration
+            << ",\"pid\":" << pid << ",\"tid\":" << event.tid
+            << ",\"args\":{\"processPeakRssKb\":" << event.processPeakRssKb
+            << ",\"peakRssGrowthKb\":" << event.peakRssGrowthKb
+            << ",\"childPeakRssKb\":" << event.childPeakRssKb << "}},\n";
+    }//_for
+    file.close();
+    it->second.clear();
+}
+
+/********************************************
+ *             Scope Defintions             *
+ ********************************************/
+
+void CemrgTrace::Scope::Begin(const char* name, const QString& directory) {
+
+    if (traceTid < 0)
+        traceTid = traceThreads++;
+    this->name = name;
+    this->directory = directory.isEmpty() ? QString(".") : directory;
+    this->start = NowMicroseconds();
+    long long childKb;
+    PeakMemory(startPeakRssKb, childKb);
+    traceDepth++;
+}
+
+void CemrgTrace::Scope::End() {
+
+    TraceEvent event;
+    event.name = name;
+    event.start = start;
+    event.duration = NowMicroseconds() - start;
+    event.tid = traceTid;
+    PeakMemory(event.processPeakRssKb, event.childPeakRssKb);
+    event.peakRssGrowthKb = event.processPeakRssKb - startPeakRssKb;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceEvents[directory].push_back(event);
+    }
+
+    //Outermost span of this thread, keep the file on disk current
+    if (--traceDepth == 0)
+        CemrgTrace::Flush(directory);
+}
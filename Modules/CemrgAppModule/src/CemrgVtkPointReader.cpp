@@ -0,0 +1,252 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Fast VTK Point Reader for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qt
+#include <QFile>
+
+//Std
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include "CemrgVtkPointReader.h"
+
+namespace {
+
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    void SkipSpace(const char*& cursor, const char* end) {
+        while (cursor < end && IsSpace(*cursor))
+            cursor++;
+    }
+
+    //Next whitespace separated token, [begin, end) into the mapped file
+    bool NextToken(const char*& cursor, const char* end, const char*& tokenBegin, const char*& tokenEnd) {
+        SkipSpace(cursor, end);
+        tokenBegin = cursor;
+        while (cursor < end && !IsSpace(*cursor))
+            cursor++;
+        tokenEnd = cursor;
+        return tokenBegin < tokenEnd;
+    }
+
+    bool TokenIs(const char* tokenBegin, const char* tokenEnd, const char* word) {
+        size_t length = std::strlen(word);
+        if ((size_t)(tokenEnd - tokenBegin) != length)
+            return false;
+        for (size_t i=0; i<length; i++)
+            if (std::toupper((unsigned char)tokenBegin[i]) != word[i])
+                return false;
+        return true;
+    }
+
+    void SkipLine(const char*& cursor, const char* end) {
+        while (cursor < end && *cursor != '\n')
+            cursor++;
+        if (cursor < end)
+            cursor++;
+    }
+
+    template<typename T>
+    T BigEndian(const char* bytes) {
+        unsigned char swapped[sizeof(T)];
+        for (size_t i=0; i<sizeof(T); i++)
+            swapped[i] = (unsigned char)bytes[sizeof(T)-1-i];
+        T value;
+        const uint16_t probe = 1;
+        std::memcpy(&value, (*(const unsigned char*)&probe == 1) ? (const void*)swapped : (const void*)bytes, sizeof(T));
+        return value;
+    }
+}
+
+CemrgVtkPointReader::CemrgVtkPointReader() {
+
+    flipXY = true;
+}
+
+void CemrgVtkPointReader::SetFlipXY(bool value) {
+
+    flipXY = value;
+}
+
+const std::vector<double>& CemrgVtkPointReader::GetCoordinates() const {
+
+    return coordinates;
+}
+
+size_t CemrgVtkPointReader::GetNumberOfPoints() const {
+
+    return coordinates.size() / 3;
+}
+
+bool CemrgVtkPointReader::Read(QString path) {
+
+    coordinates.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+        return false;
+
+    //Map the file, fall back to a single read where mapping is unavailable
+    const char* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+    QByteArray buffer;
+    if (data == NULL) {
+        buffer = file.readAll();
+        data = buffer.constData();
+    }//_if
+    bool ok = ParsePoints(data, data + file.size());
+    if (!ok)
+        coordinates.clear();
+    file.close();
+    return ok;
+}
+
+bool CemrgVtkPointReader::ParseDouble(const char*& cursor, const char* end, double& value) {
+
+    //Exact powers of ten, products with them are correctly rounded
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    SkipSpace(cursor, end);
+    const char* start = cursor;
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+        negative = *cursor++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool anyDigit = false;
+    for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++, anyDigit = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            if (mantissa) digits++;
+        } else
+            exponent++;
+    }//_for
+    if (cursor < end && *cursor == '.') {
+        for (cursor++; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++, anyDigit = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*cursor - '0');
+                if (mantissa) digits++;
+                exponent--;
+            }//_if
+        }//_for
+    }//_if
+
+    //Infinity and nan as written by the VTK writers
+    if (!anyDigit) {
+        const char* token = cursor;
+        while (cursor < end && !IsSpace(*cursor))
+            cursor++;
+        if (TokenIs(token, cursor, "NAN")) {
+            value = NAN;
+            return true;
+        } else if (TokenIs(token, cursor, "INF") || TokenIs(token, cursor, "INFINITY")) {
+            value = negative ? -INFINITY : INFINITY;
+            return true;
+        }//_if
+        cursor = start;
+        return false;
+    }//_if
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        const char* mark = cursor++;
+        bool expNegative = false;
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            expNegative = *cursor++ == '-';
+        if (cursor < end && *cursor >= '0' && *cursor <= '9') {
+            int e = 0;
+            for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+                if (e < 10000) e = e * 10 + (*cursor - '0');
+            exponent += expNegative ? -e : e;
+        } else
+            cursor = mark;
+    }//_if
+
+    double result = (double)mantissa;
+    if (mantissa == 0)
+        result = 0.0;
+    else if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    else if (exponent < 0)
+        result = (double)((long double)mantissa / std::pow(10.0L, -exponent));
+    else
+        result = (double)((long double)mantissa * std::pow(10.0L, exponent));
+    value = negative ? -result : result;
+    return true;
+}
+
+bool CemrgVtkPointReader::ParsePoints(const char* data, const char* end) {
+
+    //Header: version, title, format and dataset lines
+    const char* cursor = data;
+    const char *tokenBegin, *tokenEnd;
+    SkipLine(cursor, end);
+    SkipLine(cursor, end);
+    if (!NextToken(cursor, end, tokenBegin, tokenEnd))
+        return false;
+    bool binary = TokenIs(tokenBegin, tokenEnd, "BINARY");
+    if (!binary && !TokenIs(tokenBegin, tokenEnd, "ASCII"))
+        return false;
+
+    //Seek the POINTS keyword
+    while (NextToken(cursor, end, tokenBegin, tokenEnd) && !TokenIs(tokenBegin, tokenEnd, "POINTS"));
+    if (cursor >= end)
+        return false;
+    double count;
+    if (!ParseDouble(cursor, end, count) || count < 0)
+        return false;
+    if (!NextToken(cursor, end, tokenBegin, tokenEnd))
+        return false;
+    bool isFloat = TokenIs(tokenBegin, tokenEnd, "FLOAT");
+    if (!isFloat && !TokenIs(tokenBegin, tokenEnd, "DOUBLE"))
+        return false;
+
+    //Coordinates are negated while they are stored
+    size_t noValues = 3 * (size_t)count;
+    coordinates.resize(noValues);
+    double* out = coordinates.data();
+    const double signs[3] = {flipXY ? -1.0 : 1.0, flipXY ? -1.0 : 1.0, 1.0};
+    if (binary) {
+        SkipLine(cursor, end);
+        size_t size = isFloat ? sizeof(float) : sizeof(double);
+        if ((size_t)(end - cursor) < noValues * size)
+            return false;
+        for (size_t i=0; i<noValues; i++, cursor += size)
+            out[i] = signs[i%3] * (isFloat ? (double)BigEndian<float>(cursor) : BigEndian<double>(cursor));
+    } else {
+        for (size_t i=0; i<noValues; i++) {
+            if (!ParseDouble(cursor, end, out[i]))
+                return false;
+            out[i] *= signs[i%3];
+        }//_for
+    }//_if
+    return true;
+}
@@ -0,0 +1,420 @@
+/*=========================================================================
+
+Program:   Medical Imaging & Interaction Toolkit
+Language:  C++
+Date:      $Date$
+Version:   $Revision$
+
+Copyright (c) German Cancer Research Center, Division of Medical and
+Biological Informatics. All rights reserved.
+See MITKCopyright.txt or http://www.mitk.org/copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+/*=========================================================================
+ *
+ * Wall Thickness for MITK
+ *
+ * Cardiac Electromechanics Research Group
+ * http://www.cemrg.co.uk/
+ * orod.razeghi@kcl.ac.uk
+ *
+ * This software is distributed WITHOUT ANY WARRANTY or SUPPORT!
+ *
+=========================================================================*/
+
+//Qmitk
+#include <mitkLogMacros.h>
+
+//VTK
+#include <vtkSmartPointer.h>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+
+//Std
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+#include "CemrgWallThickness.h"
+#include "CemrgRunLengthImage.h"
+#include "CemrgJobScheduler.h"
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+//Wall voxel of the region of interest
+struct WallVoxel {
+    int offset;
+    int x, y, z;
+};
+
+//Potential gradient on the region of interest, in physical units
+struct GradientField {
+    int size[3];
+    double spacing[3];
+    std::vector<float> component[3];
+    std::vector<char> wall;
+};
+
+float Interpolate(const std::vector<float>& values, const int size[3], const double p[3]) {
+
+    int lo[3], hi[3];
+    double f[3];
+    for (int a=0; a<3; a++) {
+        double c = std::min(std::max(p[a], 0.0), size[a] - 1.0);
+        lo[a] = std::min((int)c, std::max(0, size[a] - 2));
+        hi[a] = std::min(lo[a] + 1, size[a] - 1);
+        f[a] = c - lo[a];
+    }//_for
+
+    int sy = size[0], sz = size[0] * size[1];
+    double value = 0;
+    for (int k=0; k<2; k++) {
+        for (int j=0; j<2; j++) {
+            for (int i=0; i<2; i++) {
+                double weight = (i ? f[0] : 1 - f[0]) * (j ? f[1] : 1 - f[1]) * (k ? f[2] : 1 - f[2]);
+                value += weight * values[(i ? hi[0] : lo[0]) + (j ? hi[1] : lo[1]) * sy + (k ? hi[2] : lo[2]) * sz];
+            }//_for
+        }//_for
+    }//_for
+    return value;
+}
+
+//Unit step along the gradient, converted to index units
+bool Direction(const GradientField& field, const double p[3], double sign, double d[3]) {
+
+    double g[3], norm = 0;
+    for (int a=0; a<3; a++) {
+        g[a] = Interpolate(field.component[a], field.size, p);
+        norm += g[a] * g[a];
+    }//_for
+    if (norm < 1e-20)
+        return false;
+    norm = sign / std::sqrt(norm);
+    for (int a=0; a<3; a++)
+        d[a] = g[a] * norm / field.spacing[a];
+    return true;
+}
+
+//Midpoint integration until the streamline leaves the wall
+double Trace(const GradientField& field, const double start[3], double sign, double step, int maxSteps) {
+
+    double p[3] = {start[0], start[1], start[2]};
+    double d[3], mid[3];
+    for (int s=0; s<maxSteps; s++) {
+
+        if (!Direction(field, p, sign, d))
+            return s * step;
+        for (int a=0; a<3; a++)
+            mid[a] = p[a] + 0.5 * step * d[a];
+        if (!Direction(field, mid, sign, d))
+            return s * step;
+        for (int a=0; a<3; a++)
+            p[a] += step * d[a];
+
+        //The wall boundary lies half a step back on average
+        int offset = 0, stride = 1;
+        for (int a=0; a<3; a++) {
+            int i = (int)std::floor(p[a] + 0.5);
+            if (i < 0 || i >= field.size[a])
+                return (s + 0.5) * step;
+            offset += i * stride;
+            stride *= field.size[a];
+        }//_for
+        if (!field.wall[offset])
+            return (s + 0.5) * step;
+    }//_for
+    return maxSteps * step;
+}
+
+}//_namespace
+
+
+CemrgWallThickness::CemrgWallThickness() {
+
+    wallLabel = 2;
+    bloodPoolLabel = 1;
+    tolerance = 1e-5;
+    maxIterations = 5000;
+    status = NO_INPUT;
+    iterations = 0;
+    residual = 0;
+}
+
+void CemrgWallThickness::SetLabels(short wallLabel, short bloodPoolLabel) {
+
+    this->wallLabel = wallLabel;
+    this->bloodPoolLabel = bloodPoolLabel;
+}
+
+void CemrgWallThickness::SetTolerance(double tolerance) {
+
+    this->tolerance = tolerance;
+}
+
+void CemrgWallThickness::SetMaximumIterations(int iterations) {
+
+    maxIterations = std::max(1, iterations);
+}
+
+bool CemrgWallThickness::Compute(LabelImageType::Pointer segmentation) {
+
+    iterations = 0;
+    residual = 0;
+    thickness = NULL;
+    status = NO_INPUT;
+    if (segmentation.IsNull() || wallLabel == bloodPoolLabel)
+        return false;
+
+    //Box around the wall with one voxel of boundary conditions
+    CemrgRunLengthImage runImage(segmentation);
+    LabelImageType::RegionType box;
+    status = NO_WALL;
+    if (!runImage.GetBoundingBox(wallLabel, box))
+        return false;
+    status = NO_BLOOD_POOL;
+    if (runImage.GetVoxelCount(bloodPoolLabel) == 0)
+        return false;
+    LabelImageType::RegionType buffered = segmentation->GetBufferedRegion();
+    box.PadByRadius(1);
+    box.Crop(buffered);
+
+    int size[3], start[3], full[3];
+    for (int a=0; a<3; a++) {
+        size[a] = box.GetSize()[a];
+        start[a] = box.GetIndex()[a] - buffered.GetIndex()[a];
+        full[a] = buffered.GetSize()[a];
+    }//_for
+    int sy = size[0], sz = size[0] * size[1];
+    int noVoxels = sz * size[2];
+
+    //Dirichlet values, 0 on the blood pool and 1 elsewhere
+    const short* seg = segmentation->GetBufferPointer();
+    std::vector<float> potential(noVoxels, 1);
+    std::vector<char> wall(noVoxels, 0);
+    std::vector<WallVoxel> colours[2];
+    long long noContacts = 0, noBloodPool = 0;
+    for (int z=0; z<size[2]; z++) {
+        for (int y=0; y<size[1]; y++) {
+            const short* row = seg + start[0] + (long long)(start[1] + y) * full[0] + (long long)(start[2] + z) * full[0] * full[1];
+            for (int x=0; x<size[0]; x++) {
+                int offset = x + y * sy + z * sz;
+                if (row[x] == bloodPoolLabel) {
+                    potential[offset] = 0;
+                    noBloodPool++;
+                } else if (row[x] == wallLabel) {
+                    WallVoxel voxel = {offset, x, y, z};
+                    potential[offset] = 0.5;
+                    wall[offset] = 1;
+                    colours[(x + y + z) % 2].push_back(voxel);
+                }//_if
+            }//_for
+        }//_for
+    }//_for
+    status = NO_CONTACT;
+    if (noBloodPool == 0)
+        return false;
+
+    //Wall voxels facing the blood pool give the mean wall depth in voxels
+    long long noWall = colours[0].size() + colours[1].size();
+    for (int c=0; c<2; c++) {
+        for (size_t j=0; j<colours[c].size(); j++) {
+            const WallVoxel& v = colours[c][j];
+            if ((v.x > 0 && potential[v.offset-1] == 0) || (v.x < size[0]-1 && potential[v.offset+1] == 0) ||
+                (v.y > 0 && potential[v.offset-sy] == 0) || (v.y < size[1]-1 && potential[v.offset+sy] == 0) ||
+                (v.z > 0 && potential[v.offset-sz] == 0) || (v.z < size[2]-1 && potential[v.offset+sz] == 0))
+                noContacts++;
+        }//_for
+    }//_for
+    if (noContacts == 0)
+        return false;
+
+    //Both faces are fixed, so the slowest mode spans the wall depth rather than the box
+    double depth = 2.0 * noWall / noContacts + 2;
+    double omega = std::min(1.95, 2.0 / (1.0 + std::sin(M_PI / depth)));
+    LabelImageType::SpacingType spacing = segmentation->GetSpacing();
+    double weight[3], denominator = 0;
+    for (int a=0; a<3; a++) {
+        weight[a] = 1.0 / (spacing[a] * spacing[a]);
+        denominator += 2 * weight[a];
+    }//_for
+
+    //Voxels of one colour only have neighbours of the other colour
+    auto Sweep = [&](const std::vector<WallVoxel>& colour) {
+        double maxChange = 0;
+        std::mutex changeMutex;
+        CemrgJobScheduler::ParallelFor(colour.size(), [&](int begin, int end) {
+            double localChange = 0;
+            for (int j=begin; j<end; j++) {
+                const WallVoxel& v = colour[j];
+                const int c = v.offset;
+                //Mirrored at the edges of the image
+                double sum = weight[0] * ((v.x > 0 ? potential[c-1] : potential[c]) + (v.x < size[0]-1 ? potential[c+1] : potential[c]));
+                sum += weight[1] * ((v.y > 0 ? potential[c-sy] : potential[c]) + (v.y < size[1]-1 ? potential[c+sy] : potential[c]));
+                sum += weight[2] * ((v.z > 0 ? potential[c-sz] : potential[c]) + (v.z < size[2]-1 ? potential[c+sz] : potential[c]));
+                double change = omega * (sum / denominator - potential[c]);
+                potential[c] += change;
+                localChange = std::max(localChange, std::abs(change));
+            }//_for
+            std::lock_guard<std::mutex> lock(changeMutex);
+            maxChange = std::max(maxChange, localChange);
+        }, 4096);
+        return maxChange;
+    };
+
+    while (iterations < maxIterations) {
+        double redChange = Sweep(colours[0]);
+        double blackChange = Sweep(colours[1]);
+        residual = std::max(redChange, blackChange);
+        iterations++;
+        if (residual < tolerance)
+            break;
+    }//_while
+    MITK_INFO << "Laplace solver: " << iterations << " iterations, last change " << residual << ", omega " << omega;
+
+    status = SUCCESS;
+
+    //Central differences, one sided at the edges of the box
+    GradientField field;
+    for (int a=0; a<3; a++) {
+        field.size[a] = size[a];
+        field.spacing[a] = spacing[a];
+        field.component[a].resize(noVoxels);
+    }//_for
+    CemrgJobScheduler::ParallelFor(size[2], [&](int begin, int end) {
+        for (int z=begin; z<end; z++) {
+            for (int y=0; y<size[1]; y++) {
+                for (int x=0; x<size[0]; x++) {
+                    int c = x + y * sy + z * sz;
+                    int index[3] = {x, y, z};
+                    int stride[3] = {1, sy, sz};
+                    for (int a=0; a<3; a++) {
+                        int lo = index[a] > 0 ? 1 : 0;
+                        int hi = index[a] < size[a]-1 ? 1 : 0;
+                        field.component[a][c] = (lo + hi) == 0 ? 0.0f :
+                                (potential[c + hi*stride[a]] - potential[c - lo*stride[a]]) / ((lo + hi) * spacing[a]);
+                    }//_for
+                }//_for
+            }//_for
+        }//_for
+    }, 4);
+    field.wall.swap(wall);
+
+    //Thickness is the streamline length through each wall voxel
+    thickness = FloatImageType::New();
+    thickness->SetRegions(buffered);
+    thickness->SetOrigin(segmentation->GetOrigin());
+    thickness->SetSpacing(segmentation->GetSpacing());
+    thickness->SetDirection(segmentation->GetDirection());
+    thickness->Allocate();
+    thickness->FillBuffer(0);
+    float* out = thickness->GetBufferPointer();
+    double step = 0.25 * std::min(spacing[0], std::min(spacing[1], spacing[2]));
+    int maxSteps = (int)(2 * (size[0] * spacing[0] + size[1] * spacing[1] + size[2] * spacing[2]) / step);
+    for (int c=0; c<2; c++) {
+        const std::vector<WallVoxel>& colour = colours[c];
+        CemrgJobScheduler::ParallelFor(colour.size(), [&](int begin, int end) {
+            for (int j=begin; j<end; j++) {
+                const WallVoxel& v = colour[j];
+                double p[3] = {(double)v.x, (double)v.y, (double)v.z};
+                double length = Trace(field, p, 1, step, maxSteps) + Trace(field, p, -1, step, maxSteps);
+                out[(v.x + start[0]) + (long long)(v.y + start[1]) * full[0] + (long long)(v.z + start[2]) * full[0] * full[1]] = length;
+            }//_for
+        }, 1024);
+    }//_for
+    return true;
+}
+
+CemrgWallThickness::Status CemrgWallThickness::GetStatus() const {
+
+    return status;
+}
+
+int CemrgWallThickness::GetIterations() const {
+
+    return iterations;
+}
+
+double CemrgWallThickness::GetResidual() const {
+
+    return residual;
+}
+
+CemrgWallThickness::FloatImageType::Pointer CemrgWallThickness::GetThickness() const {
+
+    return thickness;
+}
+
+int CemrgWallThickness::SampleOnSurface(vtkPolyData* surface, std::string arrayName, double radius) const {
+
+    if (thickness.IsNull() || surface == NULL)
+        return 0;
+
+    int noPoints = surface->GetNumberOfPoints();
+    vtkSmartPointer<vtkFloatArray> values = vtkSmartPointer<vtkFloatArray>::New();
+    values->SetName(arrayName.c_str());
+    values->SetNumberOfComponents(1);
+    values->SetNumberOfTuples(noPoints);
+
+    FloatImageType::RegionType region = thickness->GetBufferedRegion();
+    FloatImageType::SpacingType spacing = thickness->GetSpacing();
+    int reach[3];
+    for (int a=0; a<3; a++)
+        reach[a] = std::max(1, (int)std::ceil(radius / spacing[a]));
+
+    std::atomic<int> matched(0);
+    CemrgJobScheduler::ParallelFor(noPoints, [&](int begin, int end) {
+        int localMatched = 0;
+        for (int i=begin; i<end; i++) {
+
+            double x[3];
+            surface->GetPoint(i, x);
+            FloatImageType::PointType point;
+            point[0] = x[0]; point[1] = x[1]; point[2] = x[2];
+            itk::ContinuousIndex<double,3> centre;
+            thickness->TransformPhysicalPointToContinuousIndex(point, centre);
+
+            //Nearest wall voxel in the search radius
+            float value = 0;
+            double nearest = radius * radius;
+            FloatImageType::IndexType index;
+            for (int dz=-reach[2]; dz<=reach[2]; dz++) {
+                for (int dy=-reach[1]; dy<=reach[1]; dy++) {
+                    for (int dx=-reach[0]; dx<=reach[0]; dx++) {
+                        index[0] = (long)std::floor(centre[0] + 0.5) + dx;
+                        index[1] = (long)std::floor(centre[1] + 0.5) + dy;
+                        index[2] = (long)std::floor(centre[2] + 0.5) + dz;
+                        if (!region.IsInside(index))
+                            continue;
+                        float t = thickness->GetPixel(index);
+                        if (t <= 0)
+                            continue;
+                        double distance = 0;
+                        for (int a=0; a<3; a++)
+                            distance += std::pow((index[a] - centre[a]) * spacing[a], 2);
+                        if (distance <= nearest) {
+                            nearest = distance;
+                            value = t;
+                        }//_if
+                    }//_for
+                }//_for
+            }//_for
+            values->SetValue(i, value);
+            if (value > 0)
+                localMatched++;
+        }//_for
+        matched += localMatched;
+    }, 1024);
+
+    surface->GetPointData()->AddArray(values);
+    surface->GetPointData()->SetActiveScalars(arrayName.c_str());
+    return matched;
+}
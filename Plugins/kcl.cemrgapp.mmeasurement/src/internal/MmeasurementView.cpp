@@ -283,23 +283,8 @@ void MmeasurementView::CropinIMGS() {
 
             this->BusyCursorOn();
             mitk::ProgressBar::GetInstance()->AddStepsToDo((timePoints-1)*2);
-
-            for (int i=1; i<timePoints; i++) {
-
-                mitk::Image::Pointer inputImage;
-                path = directory + mitk::IOUtil::GetDirectorySeparator() + "dcm-" + QString::number(i) + ".nii";
-                try {
-                    inputImage = dynamic_cast<mitk::Image*>(
-                                mitk::IOUtil::Load(path.toStdString()).front().GetPointer());
-                } catch(const std::exception& e) {
-                    continue;
-                }//_try
-
-                //Setup cropper
-                CemrgImageUtils::SetImageToCut(inputImage);
-                outputImage = CemrgImageUtils::CropImage();
-                mitk::IOUtil::Save(outputImage, path.toStdString());
-            }//_for
+            CemrgImageUtils cropper(CemrgImageUtils::GetCuttingCube(), CemrgImageUtils::GetImageToCut());
+            cropper.CropSeries(directory, timePoints, 1);
 
             this->BusyCursorOff();
         }//_if
@@ -414,23 +399,8 @@ void MmeasurementView::ResampIMGS() {
                 if (reply == QMessageBox::Yes) {
 
                     this->BusyCursorOn();
-                    mitk::ProgressBar::GetInstance()->AddStepsToDo(9);
-                    for (int i=1; i<timePoints; i++) {
-
-                        mitk::Image::Pointer inputImage;
-                        path = directory + mitk::IOUtil::GetDirectorySeparator() + "dcm-" + QString::number(i) + ".nii";
-                        try {
-                            inputImage = dynamic_cast<mitk::Image*>(
-                                        mitk::IOUtil::Load(path.toStdString()).front().GetPointer());
-                        } catch(const std::exception& e) {
-                            continue;
-                        }//_try
-
-                        //Setup sampler
-                        outputImage = CemrgImageUtils::Downsample(inputImage, factor);
-                        mitk::IOUtil::Save(outputImage, path.toStdString());
-
-                    }//_for
+                    mitk::ProgressBar::GetInstance()->AddStepsToDo(timePoints-1);
+                    CemrgImageUtils::DownsampleSeries(directory, timePoints, factor, 1);
                     this->BusyCursorOff();
                 }//_if
             }//_if
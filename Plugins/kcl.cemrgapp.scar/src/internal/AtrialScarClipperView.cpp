@@ -48,6 +48,7 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vtkRenderWindow.h>
 #include <vtkProperty.h>
 #include <vtkCellPicker.h>
+#include <vtkCellLocator.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkCell.h>
 #include <vtkMath.h>
@@ -133,6 +134,8 @@ void AtrialScarClipperView::CreateQtPartControl(QWidget *parent){
       pickedCutterSeeds->Initialize();
       pickedCutterSeeds->SetPoints(vtkSmartPointer<vtkPoints>::New());
       clipper = std::unique_ptr<CemrgAtriaClipper>(new CemrgAtriaClipper(directory, surface));
+      segImage = NULL;
+      clippedNode = NULL;
       Visualiser();
   }
 
@@ -355,15 +358,24 @@ void AtrialScarClipperView::CtrPlanes() {
 
 void AtrialScarClipperView::ClipperImage() {
 
-    if (this->GetDataManagerSelection().empty()) {
-        QMessageBox::warning(NULL, "Attention", "Please select the loaded or created segmentation to clip!");
-        return;
-    } else if (clipper->GetCentreLines().size() == 0) {
+    if (clipper->GetCentreLines().size() == 0) {
         QMessageBox::warning(NULL, "Attention", "Please maske sure you have computed centre lines!");
         return;
     } else if (clipper->GetCentreLinePolyPlanes().size() == 0) {
         QMessageBox::warning(NULL, "Attention", "Please maske sure you have computed clipper planes!");
         return;
+    } else if (segImage) {
+
+        //Re-clip the original segmentation, only adjusted cutters are rasterised again
+        this->BusyCursorOn();
+        this->GetDataStorage()->Remove(clippedNode);
+        mitk::ProgressBar::GetInstance()->AddStepsToDo(pickedSeedLabels.size());
+        clipper->ClipVeinsImage(pickedSeedLabels, segImage, false);
+        this->BusyCursorOff();
+
+    } else if (this->GetDataManagerSelection().empty()) {
+        QMessageBox::warning(NULL, "Attention", "Please select the loaded or created segmentation to clip!");
+        return;
     } else {
 
         //Check for selection of segmentation image
@@ -387,6 +399,7 @@ void AtrialScarClipperView::ClipperImage() {
                 mitk::ProgressBar::GetInstance()->AddStepsToDo(pickedSeedLabels.size());
                 clipper->ClipVeinsImage(pickedSeedLabels, image, false);
                 this->BusyCursorOff();
+                segImage = image;
                 QMessageBox::information(NULL, "Attention", "Segmentation is now clipped!");
 
             } else {
@@ -405,12 +418,7 @@ void AtrialScarClipperView::ClipperImage() {
     node->SetData(clipper->GetClippedSegImage());
     node->SetName("PVeinsCroppedImage");
     this->GetDataStorage()->Add(node);
-
-    //Adjust controllers
-    m_Controls.slider->setEnabled(false);
-    m_Controls.spinBox->setEnabled(false);
-    m_Controls.comboBox->setEnabled(false);
-    m_Controls.button_4->setEnabled(false);
+    clippedNode = node;
 }
 
 void AtrialScarClipperView::CtrPlanesPlacer() {
@@ -492,6 +500,19 @@ void AtrialScarClipperView::Visualiser() {
     glyphActor->PickableOff();
     renderer->AddActor(glyphActor);
 
+    //Cutter seeds glyph, shown once manual cutting starts
+    vtkSmartPointer<vtkGlyph3D> cutterGlyph3D = vtkSmartPointer<vtkGlyph3D>::New();
+    cutterGlyph3D->SetInputData(pickedCutterSeeds);
+    cutterGlyph3D->SetSourceConnection(glyphSource->GetOutputPort());
+    cutterGlyph3D->SetScaleModeToDataScalingOff();
+    cutterGlyph3D->SetScaleFactor(surface->GetVtkPolyData()->GetLength()*0.01);
+    vtkSmartPointer<vtkPolyDataMapper> cutterGlyphMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    cutterGlyphMapper->SetInputConnection(cutterGlyph3D->GetOutputPort());
+    cutterGlyphActor = vtkSmartPointer<vtkActor>::New();
+    cutterGlyphActor->SetMapper(cutterGlyphMapper);
+    cutterGlyphActor->GetProperty()->SetColor(1.0,0.0,0.0);
+    cutterGlyphActor->PickableOff();
+
     //Create a mapper and actor for surface
     vtkSmartPointer<vtkPolyDataMapper> surfMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
     surfMapper->SetInputData(surface->GetVtkPolyData());
@@ -504,11 +525,31 @@ void AtrialScarClipperView::Visualiser() {
 
 void AtrialScarClipperView::PickCallBack() {
 
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
-    picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
+    vtkIdType pickedSeedId = PickSeedId();
+    if (pickedSeedId == -1) return;
+
+    pickedSeedIds->InsertNextId(pickedSeedId);
+    double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
+    pickedLineSeeds->GetPoints()->InsertNextPoint(point);
+    pickedLineSeeds->Modified();
+    m_Controls.widget_1->GetRenderWindow()->Render();
+}
+
+vtkIdType AtrialScarClipperView::PickSeedId() {
+
+    //Persistent picker, its locator is built once per surface
+    if (picker == NULL || cellLocator->GetDataSet() != surface->GetVtkPolyData()) {
+        cellLocator = vtkSmartPointer<vtkCellLocator>::New();
+        cellLocator->SetDataSet(surface->GetVtkPolyData());
+        cellLocator->BuildLocator();
+        picker = vtkSmartPointer<vtkCellPicker>::New();
+        picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
+        picker->AddLocator(cellLocator);
+    }//_if
+
     int* eventPosition = interactor->GetEventPosition();
     int result = picker->Pick(float(eventPosition[0]), float(eventPosition[1]), 0.0, renderer);
-    if (result == 0) return;
+    if (result == 0 || picker->GetCellId() < 0) return -1;
     double* pickPosition = picker->GetPickPosition();
     vtkIdList* pickedCellPointIds = surface->GetVtkPolyData()->GetCell(picker->GetCellId())->GetPointIds();
 
@@ -525,61 +566,24 @@ void AtrialScarClipperView::PickCallBack() {
     }//_for
     if (pickedSeedId == -1)
         pickedSeedId = pickedCellPointIds->GetId(0);
-
-    pickedSeedIds->InsertNextId(pickedSeedId);
-    double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
-    pickedLineSeeds->GetPoints()->InsertNextPoint(point);
-    pickedLineSeeds->Modified();
-    m_Controls.widget_1->GetRenderWindow()->Render();
+    return pickedSeedId;
 }
 
 void AtrialScarClipperView::ManualCutterCallBack() {
 
     if (m_Controls.label->text() != " Manual--2 ") {
 
-        vtkSmartPointer<vtkGlyph3D> glyph3D = vtkSmartPointer<vtkGlyph3D>::New();
-        vtkSmartPointer<vtkSphereSource> glyphSource = vtkSmartPointer<vtkSphereSource>::New();
-        glyph3D->SetInputData(pickedCutterSeeds);
-        glyph3D->SetSourceConnection(glyphSource->GetOutputPort());
-        glyph3D->SetScaleModeToDataScalingOff();
-        glyph3D->SetScaleFactor(surface->GetVtkPolyData()->GetLength()*0.01);
-        glyph3D->Update();
-
-        //Create a mapper and actor for glyph
-        vtkSmartPointer<vtkPolyDataMapper> glyphMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-        glyphMapper->SetInputConnection(glyph3D->GetOutputPort());
-        vtkSmartPointer<vtkActor> glyphActor = vtkSmartPointer<vtkActor>::New();
-        glyphActor->SetMapper(glyphMapper);
-        glyphActor->GetProperty()->SetColor(1.0,0.0,0.0);
-        glyphActor->PickableOff();
-        renderer->AddActor(glyphActor);
-
         //Adjust labels
         m_Controls.label->setText(" Manual--2 ");
         m_Controls.label->setStyleSheet("QLabel {border-width:1px; border-color:black; border-radius:10px; background-color:red;}");
     }//_if
 
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
-    picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
-    int* eventPosition = interactor->GetEventPosition();
-    int result = picker->Pick(float(eventPosition[0]), float(eventPosition[1]), 0.0, renderer);
-    if (result == 0) return;
-    double* pickPosition = picker->GetPickPosition();
-    vtkIdList* pickedCellPointIds = surface->GetVtkPolyData()->GetCell(picker->GetCellId())->GetPointIds();
+    //One glyph actor for all cutter seeds
+    if (!renderer->HasViewProp(cutterGlyphActor))
+        renderer->AddActor(cutterGlyphActor);
 
-    double distance;
-    int pickedSeedId = -1;
-    double minDistance = 1E10;
-    for (int i=0; i<pickedCellPointIds->GetNumberOfIds(); i++) {
-        distance = vtkMath::Distance2BetweenPoints(
-                    pickPosition, surface->GetVtkPolyData()->GetPoint(pickedCellPointIds->GetId(i)));
-        if (distance < minDistance) {
-            minDistance = distance;
-            pickedSeedId = pickedCellPointIds->GetId(i);
-        }//_if
-    }//_for
-    if (pickedSeedId == -1)
-        pickedSeedId = pickedCellPointIds->GetId(0);
+    vtkIdType pickedSeedId = PickSeedId();
+    if (pickedSeedId == -1) return;
 
     double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
     pickedCutterSeeds->GetPoints()->InsertNextPoint(point);
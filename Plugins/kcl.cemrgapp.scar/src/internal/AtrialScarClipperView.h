@@ -34,6 +34,8 @@ PURPOSE.  See the above copyright notices for more information.
 #include <QMessageBox>
 #include <vtkIdList.h>
 #include <vtkActor.h>
+#include <vtkCellPicker.h>
+#include <vtkCellLocator.h>
 #include <CemrgAtriaClipper.h>
 #include "ui_AtrialScarClipperViewControls.h"
 #include "ui_AtrialScarClipperViewLabels.h"
@@ -91,6 +93,7 @@ private:
   void Visualiser();
   void PickCallBack();
   void ManualCutterCallBack();
+  vtkIdType PickSeedId();
   static void KeyCallBackFunc(vtkObject*, long unsigned int, void* ClientData, void*);
 
   mitk::Surface::Pointer surface;
@@ -101,6 +104,11 @@ private:
   vtkSmartPointer<vtkPolyData> pickedCutterSeeds;
   std::unique_ptr<CemrgAtriaClipper> clipper;
   std::vector<vtkSmartPointer<vtkActor>> clipperActors;
+  vtkSmartPointer<vtkActor> cutterGlyphActor;
+  vtkSmartPointer<vtkCellPicker> picker;
+  vtkSmartPointer<vtkCellLocator> cellLocator;
+  mitk::Image::Pointer segImage;
+  mitk::DataNode::Pointer clippedNode;
 
   QDialog* inputs;
   static QString fileName;
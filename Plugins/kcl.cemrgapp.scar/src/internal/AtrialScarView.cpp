@@ -88,12 +88,14 @@ PURPOSE.  See the above copyright notices for more information.
 #include <QDir>
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QFile>
 #include <QStringList>
 
 // CemrgAppModule
 #include <CemrgAtriaClipper.h>
 #include <CemrgCommandLine.h>
 #include <CemrgMeasure.h>
+#include <CemrgRegistration.h>
 #include <numeric>
 
 const std::string AtrialScarView::VIEW_ID = "org.mitk.views.scar";
@@ -501,15 +503,20 @@ void AtrialScarView::Register() {
         mitk::Image::Pointer image2 = dynamic_cast<mitk::Image*>(dat2.GetPointer());
         if (image1 && image2) {
 
+            mitk::Image::Pointer lgeImage, mraImage;
             if (_1st->GetName().find("LGE") != _1st->GetName().npos && _2nd->GetName().find("MRA") != _2nd->GetName().npos) {
 
                 lge = QString::fromStdString(_1st->GetName());
                 mra = QString::fromStdString(_2nd->GetName());
+                lgeImage = image1;
+                mraImage = image2;
 
             } else if (_1st->GetName().find("MRA") != _1st->GetName().npos && _2nd->GetName().find("LGE") != _2nd->GetName().npos) {
 
                 lge = QString::fromStdString(_2nd->GetName());
                 mra = QString::fromStdString(_1st->GetName());
+                lgeImage = image2;
+                mraImage = image1;
 
             } else {
 
@@ -518,13 +525,23 @@ void AtrialScarView::Register() {
 
             }//_if
 
-            //Commandline call
+            //In-process registration, MRA is the target as in MIRTK
             this->BusyCursorOn();
             mitk::ProgressBar::GetInstance()->AddStepsToDo(1);
-            std::unique_ptr<CemrgCommandLine> cmd(new CemrgCommandLine());
-            cmd->ExecuteRegistration(directory, lge, mra);
-            QMessageBox::information(NULL, "Attention", "Command Line Operations Finished!");
-            this->BusyCursorOff();
+            QString dofPath = directory + mitk::IOUtil::GetDirectorySeparator() + "rigid.dof";
+            QString tfmPath = directory + mitk::IOUtil::GetDirectorySeparator() + "rigid.tfm";
+            std::unique_ptr<CemrgRegistration> reg(new CemrgRegistration());
+            if (reg->RigidRegistration(mraImage, lgeImage) && reg->SaveTransform(tfmPath) && reg->SaveMIRTKDof(dofPath)) {
+                this->BusyCursorOff();
+                QMessageBox::information(NULL, "Attention", "Registration Finished!");
+            } else {
+                //Commandline call
+                QFile::remove(tfmPath);
+                std::unique_ptr<CemrgCommandLine> cmd(new CemrgCommandLine());
+                cmd->ExecuteRegistration(directory, lge, mra);
+                QMessageBox::information(NULL, "Attention", "Command Line Operations Finished!");
+                this->BusyCursorOff();
+            }//_if
 
         } else {
             QMessageBox::warning(NULL, "Attention", "Please select both LGE and CEMRA images from the Data Manager!");
@@ -583,21 +600,34 @@ void AtrialScarView::Transform() {
             regFileName = QInputDialog::getText(NULL, tr("Save Registration As"), tr("File Name:"), QLineEdit::Normal, regFileName, &ok);
             if (ok && !regFileName.isEmpty() && regFileName.endsWith(".nii")) {
 
-                pathTemp = directory + mitk::IOUtil::GetDirectorySeparator() + "temp.nii";
-                mitk::IOUtil::Save(image, pathTemp.toStdString());
+                path = directory + mitk::IOUtil::GetDirectorySeparator() + regFileName;
+                QString tfmPath = directory + mitk::IOUtil::GetDirectorySeparator() + "rigid.tfm";
+                std::unique_ptr<CemrgRegistration> reg(new CemrgRegistration());
 
-                //Commandline call
                 this->BusyCursorOn();
                 mitk::ProgressBar::GetInstance()->AddStepsToDo(1);
-                std::unique_ptr<CemrgCommandLine> cmd(new CemrgCommandLine());
-                cmd->ExecuteTransformation(directory, pathTemp.right(8), regFileName);
-                QMessageBox::information(NULL, "Attention", "Command Line Operations Finished!");
-                this->BusyCursorOff();
+                if (QFile::exists(tfmPath) && reg->LoadTransform(tfmPath)) {
+
+                    //In-process resampling with the native registration
+                    mitk::IOUtil::Save(reg->TransformImage(image, true), path.toStdString());
+                    this->BusyCursorOff();
+
+                } else {
+
+                    pathTemp = directory + mitk::IOUtil::GetDirectorySeparator() + "temp.nii";
+                    mitk::IOUtil::Save(image, pathTemp.toStdString());
+
+                    //Commandline call
+                    std::unique_ptr<CemrgCommandLine> cmd(new CemrgCommandLine());
+                    cmd->ExecuteTransformation(directory, pathTemp.right(8), regFileName);
+                    QMessageBox::information(NULL, "Attention", "Command Line Operations Finished!");
+                    this->BusyCursorOff();
+                    remove(pathTemp.toStdString().c_str());
+
+                }//_if
 
                 //Load the new segementation
-                path = directory + mitk::IOUtil::GetDirectorySeparator() + regFileName;
                 mitk::IOUtil::Load(path.toStdString(), *this->GetDataStorage());
-                remove(pathTemp.toStdString().c_str());
 
                 //Clear data manager
                 mitk::DataStorage::SetOfObjects::ConstPointer sob = this->GetDataStorage()->GetAll();
@@ -45,6 +45,8 @@ PURPOSE.  See the above copyright notices for more information.
 #include <mitkDataStorageEditorInput.h>
 #include <mitkImageCast.h>
 #include <mitkITKImageImport.h>
+#include <CemrgIntensityStats.h>
+#include <CemrgJobScheduler.h>
 #include "kcl_cemrgapp_scar_Activator.h"
 #include "YZSegView.h"
 
@@ -94,6 +96,7 @@ void YZSegView::CreateQtPartControl(QWidget *parent)
   connect(m_Controls.button_4_2_1, SIGNAL(clicked()), this, SLOT(ScarSeg_4SD()));
   connect(m_Controls.button_4_2_2, SIGNAL(clicked()), this, SLOT(ScarSeg_6SD()));
   connect(m_Controls.button_4_2_3, SIGNAL(clicked()), this, SLOT(ScarSeg_CustomisedSD()));
+  connect(m_Controls.button_4_2_4, SIGNAL(clicked()), this, SLOT(ScarSeg_Compare()));
   connect(m_Controls.button_4_3, SIGNAL(clicked()), this, SLOT(ScarSeg_save()));
 
   //Set visibility of buttons
@@ -111,6 +114,7 @@ void YZSegView::CreateQtPartControl(QWidget *parent)
   m_Controls.button_4_2_1->setVisible(false);
   m_Controls.button_4_2_2->setVisible(false);
   m_Controls.button_4_2_3->setVisible(false);
+  m_Controls.button_4_2_4->setVisible(false);
   m_Controls.button_4_3->setVisible(false);
 
   //Default values
@@ -368,11 +372,10 @@ void YZSegView::ScarSeg_FWHM() {
             }
 
             //Function definitions can be found at the end of the script, here we are only declearing them
-            double FWMH_getPeak_SORT(ImageType::Pointer x);
             void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double t_min); //, double t_max, int label);
 
-            //Find the maximum infart value within LV
-            double max_inf = FWMH_getPeak_SORT(LV);
+            //Find the maximum infart value within LV, the mean of the top 0.2%
+            double max_inf = CemrgIntensityStats(LV, LV).GetTopMean(0.002);
 
             //Apply the threshold
             thresholdImage(itkImage, LV, 0.5*max_inf); //, max_inf, 1); // based on Schmidt et al. that SICore > 0.5 x Peak-infarct
@@ -396,6 +399,7 @@ void YZSegView::ScarSeg_SD() {
     m_Controls.button_4_2_1->setVisible(true);
     m_Controls.button_4_2_2->setVisible(true);
     m_Controls.button_4_2_3->setVisible(true);
+    m_Controls.button_4_2_4->setVisible(true);
 
     //Select a small region of remote left ventricular myocardium
     int reply = QMessageBox::question(
@@ -484,12 +488,13 @@ void YZSegView::ScarSeg_4SD() {
             }//_for
 
             //Declear the functions
-            double GetStats(ImageType::Pointer im, ImageType::Pointer mask, int a);
             void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double threshold);
 
-            double mean = GetStats(itkImage,itkMyo,1);
-            double std = GetStats(itkImage, itkMyo, 2);
-            double max = GetStats(itkImage,LV,3);
+            //Remote myocardium and LV wall, one pass each
+            CemrgIntensityStats myoStats(itkImage, itkMyo);
+            double mean = myoStats.GetMean();
+            double std = myoStats.GetStdDev();
+            double max = CemrgIntensityStats(itkImage, LV).GetMax();
 
             if (max > mean + 4*std)
                 thresholdImage(itkImage,LV,mean + 4*std);
@@ -576,12 +581,13 @@ void YZSegView::ScarSeg_6SD() {
             }//_for
 
             // declear the functions
-            double GetStats(ImageType::Pointer im, ImageType::Pointer mask, int a);
             void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double threshold);
 
-            double mean = GetStats(itkImage, itkMyo, 1);
-            double std = GetStats(itkImage, itkMyo, 2);
-            double max = GetStats(itkImage, LV, 3);
+            //Remote myocardium and LV wall, one pass each
+            CemrgIntensityStats myoStats(itkImage, itkMyo);
+            double mean = myoStats.GetMean();
+            double std = myoStats.GetStdDev();
+            double max = CemrgIntensityStats(itkImage, LV).GetMax();
 
             if (max > mean + 6*std)
                 thresholdImage(itkImage, LV, mean + 6*std);
@@ -668,12 +674,13 @@ void YZSegView::ScarSeg_CustomisedSD() {
             }//_for
 
             //Declear the functions
-            double GetStats(ImageType::Pointer im, ImageType::Pointer mask, int a);
             void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double threshold);
 
-            double mean = GetStats(itkImage, itkMyo, 1);
-            double std = GetStats(itkImage, itkMyo, 2);
-            double max = GetStats(itkImage, LV, 3);
+            //Remote myocardium and LV wall, one pass each
+            CemrgIntensityStats myoStats(itkImage, itkMyo);
+            double mean = myoStats.GetMean();
+            double std = myoStats.GetStdDev();
+            double max = CemrgIntensityStats(itkImage, LV).GetMax();
 
             bool ok;
             QString msg = "Please enter a whole number to set the threshold ";
@@ -696,6 +703,106 @@ void YZSegView::ScarSeg_CustomisedSD() {
     }//_if_data
 }
 
+void YZSegView::ScarSeg_Compare() {
+
+    //Check for selection of images
+    QList<mitk::DataNode::Pointer> nodes = this->GetDataManagerSelection();
+    if (nodes.size() != 3) {
+        QMessageBox::warning(
+                    NULL, "Attention",
+                    "Please select the LGE image, LV segmentation and the remote myocardium in this order from the Data Manager!");
+        return;
+    }
+
+    mitk::Image::Pointer image = dynamic_cast<mitk::Image*>(nodes.at(0)->GetData());
+    mitk::Image::Pointer seg = dynamic_cast<mitk::Image*>(nodes.at(1)->GetData());
+    mitk::Image::Pointer myo = dynamic_cast<mitk::Image*>(nodes.at(2)->GetData());
+    if (!image || !seg || !myo) {
+        QMessageBox::warning(NULL, "Attention", "Please select images from the Data Manager to segment!");
+        return;
+    }//_if
+
+    bool ok;
+    QString msg = "Please enter a whole number to set the customised threshold ";
+    int num = QInputDialog::getInt(NULL, tr("Scar Segmentation: Compare thresholds: "), msg, 0, 0, 10, 1, &ok);
+    if (!ok)
+        return;
+
+    ImageType::Pointer itkImage = ImageType::New();
+    mitk::CastToItkImage(image, itkImage);
+    ImageType::Pointer itkSeg = ImageType::New();
+    mitk::CastToItkImage(seg, itkSeg);
+    ImageType::Pointer itkMyo = ImageType::New();
+    mitk::CastToItkImage(myo, itkMyo);
+    if (itkImage->GetBufferedRegion().GetSize() != itkSeg->GetBufferedRegion().GetSize()) {
+        QMessageBox::warning(NULL, "Attention", "The LGE image and the LV segmentation must have the same size!");
+        return;
+    } else if (itkImage->GetBufferedRegion().GetSize() != itkMyo->GetBufferedRegion().GetSize()) {
+        QMessageBox::warning(NULL, "Attention", "The LGE image and the remote myocardium must have the same size!");
+        return;
+    }//_if
+
+    //Statistics once, the LV wall leaves out zero intensities as the single methods do
+    this->BusyCursorOn();
+    CemrgIntensityStats myoStats(itkImage, itkMyo);
+    if (myoStats.GetCount() == 0) {
+        this->BusyCursorOff();
+        QMessageBox::warning(NULL, "Attention", "The remote myocardium is empty, no SD thresholds can be computed!");
+        return;
+    }//_if
+    CemrgIntensityStats lvStats(itkImage, itkSeg, true);
+
+    //One bit of the output label per method
+    const int noMethods = 5;
+    QString names[noMethods] = {"2-SD", "4-SD", "6-SD", QString::number(num) + "-SD", "FWHM"};
+    double thresholds[noMethods];
+    thresholds[0] = myoStats.GetMean() + 2*myoStats.GetStdDev();
+    thresholds[1] = myoStats.GetMean() + 4*myoStats.GetStdDev();
+    thresholds[2] = myoStats.GetMean() + 6*myoStats.GetStdDev();
+    thresholds[3] = myoStats.GetMean() + num*myoStats.GetStdDev();
+    thresholds[4] = 0.5*lvStats.GetTopMean(0.002); // based on Schmidt et al. that SICore > 0.5 x Peak-infarct
+    bool inRange[noMethods];
+    for (int m=0; m<noMethods; m++)
+        inRange[m] = lvStats.GetCount() > 0 && (m == 4 || lvStats.GetMax() > thresholds[m]);
+
+    //Single sweep over the LV wall for every threshold
+    ImageType::Pointer labels = ImageType::New();
+    labels->CopyInformation(itkImage);
+    labels->SetRegions(itkImage->GetBufferedRegion());
+    labels->Allocate();
+    const short* img = itkImage->GetBufferPointer();
+    const short* msk = itkSeg->GetBufferPointer();
+    short* out = labels->GetBufferPointer();
+    CemrgJobScheduler::ParallelFor(itkImage->GetBufferedRegion().GetNumberOfPixels(), [&](int begin, int end) {
+        for (int i=begin; i<end; i++) {
+            short label = 0;
+            if (msk[i] != 0 && img[i] != 0)
+                for (int m=0; m<noMethods; m++)
+                    if (inRange[m] && img[i] >= thresholds[m])
+                        label |= (1 << m);
+            out[i] = label;
+        }//_for
+    }, 1<<16);
+
+    mitk::DataNode::Pointer node = mitk::DataNode::New();
+    node->SetData(mitk::GrabItkImageMemory(labels));
+    node->SetName("ScarThresholds");
+    this->GetDataStorage()->Add(node);
+    mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+    this->BusyCursorOff();
+
+    //Legend of the label bits
+    QString legend;
+    for (int m=0; m<noMethods; m++) {
+        legend += names[m] + ": ";
+        if (inRange[m])
+            legend += "bit " + QString::number(1 << m) + ", threshold " + QString::number(thresholds[m]) + "\n";
+        else
+            legend += "out of range, not labelled\n";
+    }//_for
+    QMessageBox::information(NULL, "Scar Thresholds", legend);
+}
+
 void YZSegView::ScarSeg_save() {
 
     //Check for selection of images
@@ -748,48 +855,6 @@ void YZSegView::ScarSeg_save() {
         return;
 }
 
-/**
- * @brief This function returns the average top 5% of the maximum intensity value in the left ventricular myocardium
- * @param x
- * @return
- */
-double FWMH_getPeak_SORT(ImageType::Pointer x) {
-
-    //Copy all the intensity values to a temporary 1D array arr, which will be sorted later
-    int m = 0;
-    ConstIteratorType in(x, x->GetRequestedRegion());
-
-    //Find the number of non-zero elements in the image
-    for (in.GoToBegin(); !in.IsAtEnd(); ++in) {
-        if (in.Get() != 0)
-            m++;
-    }
-
-    //Assign the non-zero elements to the new array arr
-    int n = 0;
-    int * arr = new int [m];
-    for (in.GoToBegin(); !in.IsAtEnd() ; ++in) {
-        if (in.Get() != 0) {
-            arr[n] = in.Get();
-            n++;
-        }
-    }
-
-    //Sort the temporary array arr in the ascending order
-    void insertion_sort(int array[], int l);
-    insertion_sort(arr, m);
-
-    //Find the average value of the top 5% of the intensity values
-    double max = 0;
-    int start = m * 0.998;
-    for (int i = start -1; i <m; i++) {
-        max += arr[i];
-    }
-	delete[] arr; 
-    max = max / (m - start);
-    return max;
-}
-
 void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double threshold) {
 
     //Create two iterators for the image and the mask
@@ -808,56 +873,3 @@ void thresholdImage(ImageType::Pointer img, ImageType::Pointer mask, double thre
         }
     }//_for
 }
-
-void insertion_sort(int array[], int l) {
-
-    int j, temp;
-    for (int i = 0; i < l; i++) {
-        j = i;
-        while (j > 0 && array[j] < array[j-1]) {
-            temp = array[j];
-            array[j] = array[j-1];
-            array[j-1] = temp;
-            j--;
-        }
-    }//_for
-}
-
-double GetStats(ImageType::Pointer im, ImageType::Pointer mask, int a) {
-
-    int n = 0;
-    double sum = 0;
-    double diff = 0;
-    double max = -1;
-
-    //Loop over the selected region of myocardium segmentation
-    IteratorType in_im(im, im->GetRequestedRegion());
-    ConstIteratorType in_mask(mask, mask->GetRequestedRegion());
-
-    for (in_im.GoToBegin(), in_mask.GoToBegin(); !in_im.IsAtEnd(); ++in_im, ++in_mask) {
-        if (in_mask.Get() != 0) {
-            if (max <= in_im.Get())
-                max = in_im.Get();
-            sum += in_im.Get();
-            n++;
-        }
-    }//_for
-
-    double mean = sum / n;
-    for (in_im.GoToBegin(), in_mask.GoToBegin(); !in_im.IsAtEnd(); ++in_im, ++in_mask) {
-        if (in_mask.Get() != 0)
-            diff += (in_im.Get() - mean) * (in_im.Get() - mean);
-    }
-
-    double sd = sqrt(diff/n);
-    if (a == 1)
-        return mean;
-    else if (a == 2)
-        return sd;
-    else if (a == 3)
-        return max;
-    else {
-        QMessageBox::warning(NULL, "Attention", "error in function GetStats");
-        return -1;
-    }
-}
@@ -67,6 +67,7 @@ protected slots:
   void ScarSeg_4SD();
   void ScarSeg_6SD();
   void ScarSeg_CustomisedSD();
+  void ScarSeg_Compare();
   void ScarSeg_save();
 
 protected:
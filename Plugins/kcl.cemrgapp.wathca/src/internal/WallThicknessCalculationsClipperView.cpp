@@ -50,6 +50,7 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vtkRenderWindow.h>
 #include <vtkProperty.h>
 #include <vtkCellPicker.h>
+#include <vtkCellLocator.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkCell.h>
 #include <vtkMath.h>
@@ -513,6 +514,19 @@ void WallThicknessCalculationsClipperView::Visualiser() {
     glyphActor->PickableOff();
     renderer->AddActor(glyphActor);
 
+    //Cutter seeds glyph, shown once manual cutting starts
+    vtkSmartPointer<vtkGlyph3D> cutterGlyph3D = vtkSmartPointer<vtkGlyph3D>::New();
+    cutterGlyph3D->SetInputData(pickedCutterSeeds);
+    cutterGlyph3D->SetSourceConnection(glyphSource->GetOutputPort());
+    cutterGlyph3D->SetScaleModeToDataScalingOff();
+    cutterGlyph3D->SetScaleFactor(surface->GetVtkPolyData()->GetLength()*0.01);
+    vtkSmartPointer<vtkPolyDataMapper> cutterGlyphMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    cutterGlyphMapper->SetInputConnection(cutterGlyph3D->GetOutputPort());
+    cutterGlyphActor = vtkSmartPointer<vtkActor>::New();
+    cutterGlyphActor->SetMapper(cutterGlyphMapper);
+    cutterGlyphActor->GetProperty()->SetColor(1.0,0.0,0.0);
+    cutterGlyphActor->PickableOff();
+
     //Create a mapper and actor for surface
     vtkSmartPointer<vtkPolyDataMapper> surfMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
     surfMapper->SetInputData(surface->GetVtkPolyData());
@@ -525,11 +539,31 @@ void WallThicknessCalculationsClipperView::Visualiser() {
 
 void WallThicknessCalculationsClipperView::PickCallBack() {
 
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
-    picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
+    vtkIdType pickedSeedId = PickSeedId();
+    if (pickedSeedId == -1) return;
+
+    pickedSeedIds->InsertNextId(pickedSeedId);
+    double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
+    pickedLineSeeds->GetPoints()->InsertNextPoint(point);
+    pickedLineSeeds->Modified();
+    m_Controls.widget_1->GetRenderWindow()->Render();
+}
+
+vtkIdType WallThicknessCalculationsClipperView::PickSeedId() {
+
+    //Persistent picker, its locator is built once per surface
+    if (picker == NULL || cellLocator->GetDataSet() != surface->GetVtkPolyData()) {
+        cellLocator = vtkSmartPointer<vtkCellLocator>::New();
+        cellLocator->SetDataSet(surface->GetVtkPolyData());
+        cellLocator->BuildLocator();
+        picker = vtkSmartPointer<vtkCellPicker>::New();
+        picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
+        picker->AddLocator(cellLocator);
+    }//_if
+
     int* eventPosition = interactor->GetEventPosition();
     int result = picker->Pick(float(eventPosition[0]), float(eventPosition[1]), 0.0, renderer);
-    if (result == 0) return;
+    if (result == 0 || picker->GetCellId() < 0) return -1;
     double* pickPosition = picker->GetPickPosition();
     vtkIdList* pickedCellPointIds = surface->GetVtkPolyData()->GetCell(picker->GetCellId())->GetPointIds();
 
@@ -546,61 +580,24 @@ void WallThicknessCalculationsClipperView::PickCallBack() {
     }//_for
     if (pickedSeedId == -1)
         pickedSeedId = pickedCellPointIds->GetId(0);
-
-    pickedSeedIds->InsertNextId(pickedSeedId);
-    double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
-    pickedLineSeeds->GetPoints()->InsertNextPoint(point);
-    pickedLineSeeds->Modified();
-    m_Controls.widget_1->GetRenderWindow()->Render();
+    return pickedSeedId;
 }
 
 void WallThicknessCalculationsClipperView::ManualCutterCallBack() {
 
     if (m_Controls.label->text() != " Manual--2 ") {
 
-        vtkSmartPointer<vtkGlyph3D> glyph3D = vtkSmartPointer<vtkGlyph3D>::New();
-        vtkSmartPointer<vtkSphereSource> glyphSource = vtkSmartPointer<vtkSphereSource>::New();
-        glyph3D->SetInputData(pickedCutterSeeds);
-        glyph3D->SetSourceConnection(glyphSource->GetOutputPort());
-        glyph3D->SetScaleModeToDataScalingOff();
-        glyph3D->SetScaleFactor(surface->GetVtkPolyData()->GetLength()*0.01);
-        glyph3D->Update();
-
-        //Create a mapper and actor for glyph
-        vtkSmartPointer<vtkPolyDataMapper> glyphMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-        glyphMapper->SetInputConnection(glyph3D->GetOutputPort());
-        vtkSmartPointer<vtkActor> glyphActor = vtkSmartPointer<vtkActor>::New();
-        glyphActor->SetMapper(glyphMapper);
-        glyphActor->GetProperty()->SetColor(1.0,0.0,0.0);
-        glyphActor->PickableOff();
-        renderer->AddActor(glyphActor);
-
         //Adjust labels
         m_Controls.label->setText(" Manual--2 ");
         m_Controls.label->setStyleSheet("QLabel {border-width:1px; border-color:black; border-radius:10px; background-color:red;}");
     }//_if
 
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
-    picker->SetTolerance(1E-4 * surface->GetVtkPolyData()->GetLength());
-    int* eventPosition = interactor->GetEventPosition();
-    int result = picker->Pick(float(eventPosition[0]), float(eventPosition[1]), 0.0, renderer);
-    if (result == 0) return;
-    double* pickPosition = picker->GetPickPosition();
-    vtkIdList* pickedCellPointIds = surface->GetVtkPolyData()->GetCell(picker->GetCellId())->GetPointIds();
+    //One glyph actor for all cutter seeds
+    if (!renderer->HasViewProp(cutterGlyphActor))
+        renderer->AddActor(cutterGlyphActor);
 
-    double distance;
-    int pickedSeedId = -1;
-    double minDistance = 1E10;
-    for (int i=0; i<pickedCellPointIds->GetNumberOfIds(); i++) {
-        distance = vtkMath::Distance2BetweenPoints(
-                    pickPosition, surface->GetVtkPolyData()->GetPoint(pickedCellPointIds->GetId(i)));
-        if (distance < minDistance) {
-            minDistance = distance;
-            pickedSeedId = pickedCellPointIds->GetId(i);
-        }//_if
-    }//_for
-    if (pickedSeedId == -1)
-        pickedSeedId = pickedCellPointIds->GetId(0);
+    vtkIdType pickedSeedId = PickSeedId();
+    if (pickedSeedId == -1) return;
 
     double* point = surface->GetVtkPolyData()->GetPoint(pickedSeedId);
     pickedCutterSeeds->GetPoints()->InsertNextPoint(point);
@@ -35,6 +35,8 @@ PURPOSE.  See the above copyright notices for more information.
 #include <QMessageBox>
 #include <vtkIdList.h>
 #include <vtkActor.h>
+#include <vtkCellPicker.h>
+#include <vtkCellLocator.h>
 #include <CemrgAtriaClipper.h>
 #include "ui_WallThicknessCalculationsClipperViewControls.h"
 #include "ui_WallThicknessCalculationsClipperViewLabels.h"
@@ -84,6 +86,7 @@ private:
   void Visualiser();
   void PickCallBack();
   void ManualCutterCallBack();
+  vtkIdType PickSeedId();
   static void KeyCallBackFunc(vtkObject*, long unsigned int, void* ClientData, void*);
 
   mitk::Surface::Pointer surface;
@@ -94,6 +97,9 @@ private:
   vtkSmartPointer<vtkPolyData> pickedCutterSeeds;
   std::unique_ptr<CemrgAtriaClipper> clipper;
   std::vector<vtkSmartPointer<vtkActor>> clipperActors;
+  vtkSmartPointer<vtkActor> cutterGlyphActor;
+  vtkSmartPointer<vtkCellPicker> picker;
+  vtkSmartPointer<vtkCellLocator> cellLocator;
 
   QDialog* inputs;
   static QString fileName;
@@ -70,14 +70,7 @@ PURPOSE.  See the above copyright notices for more information.
 
 //ITK
 #include <itkAddImageFilter.h>
-#include <itkRelabelComponentImageFilter.h>
-#include <itkConnectedComponentImageFilter.h>
 #include <itkImageRegionIteratorWithIndex.h>
-#include "itkLabelObject.h"
-#include "itkLabelMap.h"
-#include "itkLabelImageToLabelMapFilter.h"
-#include "itkLabelMapToLabelImageFilter.h"
-#include "itkLabelSelectionLabelMapFilter.h"
 
 //Qt
 #include <QMessageBox>
@@ -88,6 +81,8 @@ PURPOSE.  See the above copyright notices for more information.
 #include <CemrgImageUtils.h>
 #include <CemrgCommandLine.h>
 #include <CemrgMeasure.h>
+#include <CemrgConnectedComponents.h>
+#include <CemrgWallThickness.h>
 
 const std::string WallThicknessCalculationsView::VIEW_ID = "org.mitk.views.wathcaview";
 
@@ -129,8 +124,10 @@ void WallThicknessCalculationsView::CreateQtPartControl(QWidget *parent)
   connect(m_Controls.button_3_3, SIGNAL(clicked()), this, SLOT(CombineSegs()));
   m_Controls.button_6_1->setVisible(false);
   m_Controls.button_6_2->setVisible(false);
+  m_Controls.button_6_3->setVisible(false);
   connect(m_Controls.button_6_1, SIGNAL(clicked()), this, SLOT(ConvertNRRD()));
   connect(m_Controls.button_6_2, SIGNAL(clicked()), this, SLOT(ThicknessCalculator()));
+  connect(m_Controls.button_6_3, SIGNAL(clicked()), this, SLOT(ThicknessSolver()));
 }
 
 void WallThicknessCalculationsView::LoadDICOM() {
@@ -515,37 +512,15 @@ void WallThicknessCalculationsView::MorphologyAnalysis() {
             }//_for
 
             //Relabel the components to separate bloodpool and appendage
-            typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentImageFilterType;
-            ConnectedComponentImageFilterType::Pointer connected = ConnectedComponentImageFilterType::New();
-            connected->SetInput(analyticItkImage);
-            connected->Update();
-            typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelFilterType;
-            RelabelFilterType::Pointer relabeler = RelabelFilterType::New();
-            relabeler->SetInput(connected->GetOutput());
-            relabeler->Update();
-
-            //Keep the selected labels
-            typedef itk::LabelObject<short, 3> LabelObjectType;
-            typedef itk::LabelMap<LabelObjectType> LabelMapType;
-            typedef itk::LabelImageToLabelMapFilter< ImageType, LabelMapType > LabelImageToLabelMapFilterType;
-            LabelImageToLabelMapFilterType::Pointer labelMapConverter = LabelImageToLabelMapFilterType::New();
-            labelMapConverter->SetInput(relabeler->GetOutput());
-            labelMapConverter->SetBackgroundValue(0);
-            typedef itk::LabelSelectionLabelMapFilter<LabelMapType> SelectorType;
-            SelectorType::Pointer selector = SelectorType::New();
-            selector->SetInput(labelMapConverter->GetOutput());
-            selector->SetLabel(2);
-
-            //Import to MITK image
-            typedef itk::LabelMapToLabelImageFilter<LabelMapType, ImageType> LabelMapToLabelImageFilterType;
-            LabelMapToLabelImageFilterType::Pointer labelImageConverter1 = LabelMapToLabelImageFilterType::New();
-            labelImageConverter1->SetInput(selector->GetOutput(1));
-            labelImageConverter1->Update();
-            mitk::Image::Pointer bp = mitk::ImportItkImage(labelImageConverter1->GetOutput());
-            LabelMapToLabelImageFilterType::Pointer labelImageConverter2 = LabelMapToLabelImageFilterType::New();
-            labelImageConverter2->SetInput(selector->GetOutput(0));
-            labelImageConverter2->Update();
-            mitk::Image::Pointer ap = mitk::ImportItkImage(labelImageConverter2->GetOutput());
+            CemrgConnectedComponents components(analyticItkImage);
+
+            //Keep the selected labels, the second largest component is the appendage
+            std::vector<int> bpLabels;
+            for (int i=1; i<=components.GetNumberOfComponents(); i++)
+                if (i != 2)
+                    bpLabels.push_back(i);
+            mitk::Image::Pointer bp = mitk::GrabItkImageMemory(components.GetLabelledImage(bpLabels));
+            mitk::Image::Pointer ap = mitk::GrabItkImageMemory(components.GetLabelledImage(std::vector<int>(1, 2)));
 
             //Ask for user input to set the parameters
             QDialog* inputs = new QDialog(0,0);
@@ -608,10 +583,12 @@ void WallThicknessCalculationsView::MorphologyAnalysis() {
 
                 //Volume and surface calculations
                 std::unique_ptr<CemrgMeasure> morphAnal = std::unique_ptr<CemrgMeasure>(new CemrgMeasure());
-                double surfceLA = morphAnal->calcSurfaceMesh(surfLA);
-                double volumeLA = morphAnal->calcVolumeMesh(surfLA);
-                double surfceAP = morphAnal->calcSurfaceMesh(surfAP);
-                double volumeAP = morphAnal->calcVolumeMesh(surfAP);
+                CemrgMeasure::ShapeMetrics metricsLA = morphAnal->GetShapeMetrics(surfLA->GetVtkPolyData());
+                CemrgMeasure::ShapeMetrics metricsAP = morphAnal->GetShapeMetrics(surfAP->GetVtkPolyData());
+                double surfceLA = metricsLA.area;
+                double volumeLA = metricsLA.volume;
+                double surfceAP = metricsAP.area;
+                double volumeAP = metricsAP.volume;
 
                 //Store in text file
                 ofstream morphResult;
@@ -659,10 +636,12 @@ void WallThicknessCalculationsView::ThicknessAnalysis() {
     if (m_Controls.button_6_1->isVisible()) {
         m_Controls.button_6_1->setVisible(false);
         m_Controls.button_6_2->setVisible(false);
+        m_Controls.button_6_3->setVisible(false);
         return;
     } else {
         m_Controls.button_6_1->setVisible(true);
         m_Controls.button_6_2->setVisible(true);
+        m_Controls.button_6_3->setVisible(true);
     }//_if
 }
 
@@ -834,6 +813,101 @@ void WallThicknessCalculationsView::ThicknessCalculator() {
         return;
 }
 
+void WallThicknessCalculationsView::ThicknessSolver() {
+
+    //Ask the user for a dir to store data
+    if (directory.isEmpty()) {
+        directory = QFileDialog::getExistingDirectory(
+                    NULL, "Open Project Directory", mitk::IOUtil::GetProgramPath().c_str(),
+                    QFileDialog::ShowDirsOnly|QFileDialog::DontUseNativeDialog);
+        if (directory.isEmpty() || directory.simplified().contains(" ")) {
+            QMessageBox::warning(NULL, "Attention", "Please select a project directory with no spaces in the path!");
+            directory = QString();
+            return;
+        }//_if
+    }
+
+    //Check for selection of images
+    QList<mitk::DataNode::Pointer> nodes = this->GetDataManagerSelection();
+    if (nodes.empty()) {
+        QMessageBox::warning(
+                    NULL, "Attention",
+                    "Please select a segmentation, and optionally the atrial shell, from the Data Manager to calculate wall thickness!");
+        return;
+    }
+
+    //Find the selected segmentation and shell
+    mitk::Image::Pointer image;
+    mitk::Surface::Pointer shell;
+    for (int i=0; i<nodes.size(); i++) {
+        mitk::BaseData* data = nodes.at(i)->GetData();
+        if (image.IsNull() && dynamic_cast<mitk::Image*>(data))
+            image = dynamic_cast<mitk::Image*>(data);
+        if (shell.IsNull() && dynamic_cast<mitk::Surface*>(data))
+            shell = dynamic_cast<mitk::Surface*>(data);
+    }//_for
+    if (image.IsNull()) {
+        QMessageBox::warning(NULL, "Attention", "Please select a segmentation from the Data Manager!");
+        return;
+    }//_if
+
+    //Labels of the wall and the blood pool
+    bool ok1, ok2;
+    int wallLabel = QInputDialog::getInt(NULL, tr("Wall Thickness"), tr("Wall label:"), 2, 1, 255, 1, &ok1);
+    if (!ok1) return;
+    int poolLabel = QInputDialog::getInt(NULL, tr("Wall Thickness"), tr("Blood pool label:"), 1, 1, 255, 1, &ok2);
+    if (!ok2) return;
+
+    try {
+
+        //Laplace thickness of every wall voxel
+        this->BusyCursorOn();
+        mitk::ProgressBar::GetInstance()->AddStepsToDo(2);
+        itk::Image<short,3>::Pointer itkImage = itk::Image<short,3>::New();
+        mitk::CastToItkImage(image, itkImage);
+        CemrgWallThickness solver;
+        solver.SetLabels(wallLabel, poolLabel);
+        bool computed = solver.Compute(itkImage);
+        mitk::ProgressBar::GetInstance()->Progress();
+        if (!computed) {
+            mitk::ProgressBar::GetInstance()->Progress();
+            this->BusyCursorOff();
+            QString reason = "The wall label was not found in the segmentation!";
+            if (solver.GetStatus() == CemrgWallThickness::NO_BLOOD_POOL)
+                reason = "The blood pool label was not found in the segmentation!";
+            else if (solver.GetStatus() == CemrgWallThickness::NO_CONTACT)
+                reason = "The wall does not touch the blood pool, please check the labels of the segmentation!";
+            else if (solver.GetStatus() == CemrgWallThickness::NO_INPUT)
+                reason = "The wall and blood pool labels have to be different!";
+            QMessageBox::warning(NULL, "Attention", reason);
+            return;
+        }//_if
+
+        mitk::Image::Pointer thicknessImage = mitk::GrabItkImageMemory(solver.GetThickness());
+        QString path = directory + mitk::IOUtil::GetDirectorySeparator() + "thickness.nii";
+        mitk::IOUtil::Save(thicknessImage, path.toStdString());
+        AddToStorage("thickness", thicknessImage);
+
+        //Per vertex thickness on the shell
+        if (shell.IsNotNull()) {
+            mitk::Surface::Pointer thicknessShell = shell->Clone();
+            int matched = solver.SampleOnSurface(thicknessShell->GetVtkPolyData());
+            MITK_INFO << "Thickness mapped on " << matched << " of " << thicknessShell->GetVtkPolyData()->GetNumberOfPoints() << " shell points";
+            path = directory + mitk::IOUtil::GetDirectorySeparator() + "thicknessShell.vtk";
+            mitk::IOUtil::Save(thicknessShell, path.toStdString());
+            AddToStorage("thicknessShell", thicknessShell);
+        }//_if
+        mitk::ProgressBar::GetInstance()->Progress();
+        this->BusyCursorOff();
+        QMessageBox::information(NULL, "Attention", "Wall thickness calculation finished!");
+
+    } catch(mitk::Exception& e) {
+        this->BusyCursorOff();
+        MITK_ERROR << "Exception caught during wall thickness calculation: " << e.what();
+        return;
+    }//_try
+}
+
 void WallThicknessCalculationsView::Reset() {
 
     try {
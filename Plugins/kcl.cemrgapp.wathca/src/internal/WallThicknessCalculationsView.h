@@ -79,6 +79,7 @@ protected slots:
   void ConvertNRRD();
   void Browse();
   void ThicknessCalculator();
+  void ThicknessSolver();
   void Reset();
 
 protected: